@@ -0,0 +1,91 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace std::chrono;
+
+//! The byte-at-a-time loop that InternetChecksum::add used before, for comparison
+class ScalarChecksum {
+  private:
+    uint32_t _sum;
+    bool _parity{};
+
+  public:
+    explicit ScalarChecksum(const uint32_t initial_sum = 0) : _sum(initial_sum) {}
+
+    void add(const string_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint32_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+//! \returns the checksum of `data` with `ChecksumT`, and the average time per checksum in nanoseconds
+template <typename ChecksumT>
+pair<uint16_t, double> time_checksum(const string_view data, const size_t rounds) {
+    uint16_t result = 0;
+    const auto first_time = steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        ChecksumT check{uint32_t(i)};
+        check.add(data);
+        result ^= check.value();
+    }
+    const auto final_time = steady_clock::now();
+    return {result, double(duration_cast<nanoseconds>(final_time - first_time).count()) / double(rounds)};
+}
+
+//! Checksum `len` bytes both ways, starting `offset` bytes into an aligned buffer
+void checksum_loop(const size_t len, const size_t offset) {
+    string buffer(len + offset, 0);
+    for (auto &ch : buffer) {
+        ch = rand();
+    }
+    const string_view data = string_view{buffer}.substr(offset);
+    const size_t rounds = max<size_t>(100, (size_t(1) << 28) / len);
+
+    const auto [scalar_result, scalar_ns] = time_checksum<ScalarChecksum>(data, rounds);
+    const auto [result, ns] = time_checksum<InternetChecksum>(data, rounds);
+    if (result != scalar_result) {
+        throw runtime_error("checksums don't match");
+    }
+
+    cout << fixed << setprecision(1);
+    cout << setw(6) << len << " bytes at offset " << offset << ": scalar " << setw(8) << scalar_ns << " ns ("
+         << setw(5) << 8 * double(len) / scalar_ns << " Gbit/s), InternetChecksum " << setw(7) << ns << " ns ("
+         << setw(5) << 8 * double(len) / ns << " Gbit/s), " << setw(5) << scalar_ns / ns << "x\n";
+}
+
+int main() {
+    try {
+        for (const size_t len : {64, 1500, 65536}) {
+            for (const size_t offset : {0, 1}) {
+                checksum_loop(len, offset);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
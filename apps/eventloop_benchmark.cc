@@ -0,0 +1,86 @@
+#include "eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t wakeups = 20000;
+
+//! `num_fds` registered sockets, of which only one at a time has something to read (like a server with many
+//! mostly idle connections)
+void wakeup_loop(const EventLoop::Backend backend, const size_t num_fds) {
+    EventLoop eventloop{backend};
+    vector<LocalStreamSocket> readers;
+    vector<LocalStreamSocket> writers;
+    readers.reserve(num_fds);
+    writers.reserve(num_fds);
+
+    size_t bytes_read = 0;
+    for (size_t i = 0; i < num_fds; i++) {
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+        readers.emplace_back(FileDescriptor(fds[0]));
+        writers.emplace_back(FileDescriptor(fds[1]));
+        LocalStreamSocket &reader = readers.back();
+        eventloop.add_rule(reader, Direction::In, [&] { bytes_read += reader.read(1).size(); });
+    }
+
+    mt19937 rd{0};
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < wakeups; i++) {
+        writers[rd() % num_fds].write("x");
+        if (eventloop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("unexpected result from wait_next_event");
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+    if (bytes_read != wakeups) {
+        throw runtime_error("read " + to_string(bytes_read) + " bytes, expected " + to_string(wakeups));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(2);
+    const char *const name = eventloop.backend() == EventLoop::Backend::IOUring ? "io_uring"
+                             : eventloop.backend() == EventLoop::Backend::Epoll ? "epoll"
+                                                                                 : "poll";
+    cout << setw(8) << name << ", " << setw(5) << num_fds
+         << " fds: " << setw(8) << double(duration) / wakeups / 1000 << " us/wakeup\n";
+}
+
+int main() {
+    try {
+        // 每个 socketpair 占两个 fd
+        rlimit limit{};
+        SystemCall("getrlimit", ::getrlimit(RLIMIT_NOFILE, &limit));
+        limit.rlim_cur = limit.rlim_max;
+        SystemCall("setrlimit", ::setrlimit(RLIMIT_NOFILE, &limit));
+
+        for (const size_t num_fds : {size_t(10), size_t(100), size_t(1000), size_t(8000)}) {
+            if (2 * num_fds + 16 > limit.rlim_cur) {
+                cout << "skipping " << num_fds << " fds: the limit on open files is " << limit.rlim_cur << "\n";
+                continue;
+            }
+            wakeup_loop(EventLoop::Backend::Poll, num_fds);
+            wakeup_loop(EventLoop::Backend::Epoll, num_fds);
+            wakeup_loop(EventLoop::Backend::IOUring, num_fds);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
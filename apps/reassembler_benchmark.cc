@@ -0,0 +1,66 @@
+#include "stream_reassembler.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t segment_size = 100;
+
+//! Push `num_holes` * 2 segments: first every odd-numbered one (leaving `num_holes` holes buffered),
+//! then every even-numbered one, so each push has to be placed among thousands of stored segments.
+void reorder_loop(const size_t num_holes) {
+    const size_t len = 2 * num_holes * segment_size;
+    StreamReassembler reassembler{len};
+
+    string data(len, 'x');
+    for (auto &ch : data) {
+        ch = rand();
+    }
+
+    vector<size_t> order;
+    for (size_t i = 1; i < 2 * num_holes; i += 2) {
+        order.push_back(i);
+    }
+    for (size_t i = 0; i < 2 * num_holes; i += 2) {
+        order.push_back(i);
+    }
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (const size_t i : order) {
+        // each segment also overlaps half of its successor, to exercise the trimming
+        const size_t index = i * segment_size;
+        reassembler.push_substring(data.substr(index, segment_size + segment_size / 2), index, false);
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (reassembler.stream_out().read(len) != data) {
+        throw runtime_error("strings pushed vs. reassembled don't match");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << "Reassembly with " << setw(6) << num_holes << " buffered holes: " << setw(8)
+         << double(duration) / double(order.size()) << " ns/segment\n";
+}
+
+int main() {
+    try {
+        for (const size_t num_holes : {1000, 10000, 100000}) {
+            reorder_loop(num_holes);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
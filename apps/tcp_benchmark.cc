@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <string>
 
 using namespace std;
@@ -11,8 +12,34 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+//! number of heap allocations made so far (counted by the replacement operator new below)
+static size_t allocation_count = 0;
+
+void *operator new(size_t size) {
+    ++allocation_count;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+//! \param[in] drop_every if nonzero, every `drop_every`th segment carrying data is lost on the way
+//! \returns the number of segments delivered to `y`
+size_t move_segments(TCPConnection &x,
+                   TCPConnection &y,
+                   vector<TCPSegment> &segments,
+                   const bool reorder,
+                   const size_t drop_every = 0) {
+    static size_t data_segments = 0;
     while (not x.segments_out().empty()) {
+        if (drop_every and x.segments_out().front().payload().size() and ++data_segments % drop_every == 0) {
+            x.segments_out().pop();
+            continue;
+        }
         segments.emplace_back(move(x.segments_out().front()));
         x.segments_out().pop();
     }
@@ -25,11 +52,15 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
             y.segment_received(move(*it));
         }
     }
+    const size_t delivered = segments.size();
     segments.clear();
+    return delivered;
 }
 
-void main_loop(const bool reorder) {
-    TCPConfig config;
+void main_loop(const bool reorder,
+               const TCPConfig &config = {},
+               const string &label = "",
+               const size_t drop_every = 0) {
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -42,17 +73,22 @@ void main_loop(const bool reorder) {
     y.end_input_stream();
 
     bool x_closed = false;
+    size_t acks = 0;  // y has nothing to send, so everything it sends is an ACK
+    size_t delivered = 0;
 
     string string_received;
     string_received.reserve(len);
 
     const auto first_time = high_resolution_clock::now();
+    const auto first_allocation_count = allocation_count;
 
     auto loop = [&] {
         // write input into x
         while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
             const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
-            const auto written = x.write(string(bytes_to_send.str().substr(0, want)));
+            Buffer chunk = bytes_to_send;
+            chunk.remove_suffix(chunk.size() - want);
+            const auto written = x.write(move(chunk));
             if (want != written) {
                 throw runtime_error("want = " + to_string(want) + ", written = " + to_string(written));
             }
@@ -66,8 +102,9 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        delivered += move_segments(x, y, segments, reorder, drop_every);
+        acks += y.segments_out().size();
+        delivered += move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -80,8 +117,10 @@ void main_loop(const bool reorder) {
         y.tick(1000);
     };
 
+    size_t rounds = 0;
     while (not y.inbound_stream().eof()) {
         loop();
+        ++rounds;
     }
 
     if (string_received != string_to_send) {
@@ -89,6 +128,9 @@ void main_loop(const bool reorder) {
     }
 
     const auto final_time = high_resolution_clock::now();
+    const auto allocations = allocation_count - first_allocation_count;
+    const auto acks_sent = acks;
+    const auto predicted = double(x.predicted_segments() + y.predicted_segments()) / double(delivered);
 
     const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
 
@@ -96,17 +138,129 @@ void main_loop(const bool reorder) {
 
     cout << fixed << setprecision(2);
     cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+         << " Gbit/s, " << double(allocations) / (len / 1024) << " allocations/KiB, "
+         << double(acks_sent) / (len / (1024 * 1024)) << " ACKs/MiB, " << 100 * predicted << "% predicted" << label;
+    if (drop_every) {
+        // with losses, the simulated time (one second per round) matters more than the CPU time
+        cout << ", " << rounds << " rounds";
+    }
+    cout << "\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! An application making many small writes, with a round trip after every `writes_per_round` of them
+void small_writes_loop(const TCPConfig &config, const bool cork, const string &label) {
+    constexpr size_t write_size = 64;
+    constexpr size_t writes_per_round = 15;  // 960 bytes fit in one segment
+    constexpr size_t rounds = 50000;
+
+    TCPConnection x{config}, y{config};
+    x.connect();
+    y.end_input_stream();
+
+    vector<TCPSegment> segments;
+    while (x.fsm_state() != TCPState::State::ESTABLISHED) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+    }
+
+    const string message(write_size, 'x');
+    size_t data_segments = 0;
+    size_t bytes_received = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t round = 0; round < rounds; round++) {
+        if (cork) {
+            x.cork();
+        }
+        for (size_t i = 0; i < writes_per_round; i++) {
+            x.write(message);
+        }
+        if (cork) {
+            x.uncork();
+        }
+        data_segments += x.segments_out().size();
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        bytes_received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+        x.tick(1);
+        y.tick(1);
+    }
+
+    const auto final_time = high_resolution_clock::now();
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << "CPU-limited throughput, " << write_size << "-byte writes: " << bytes_received * 8.0 / double(duration)
+         << " Gbit/s, " << double(data_segments) / double(rounds * writes_per_round) << " segments/write" << label
+         << "\n";
+
+    x.end_input_stream();
+    while (x.active() or y.active()) {
+        move_segments(x, y, segments, false);
+        move_segments(y, x, segments, false);
+        x.tick(1000);
+        y.tick(1000);
+    }
+}
+
 int main() {
     try {
         main_loop(false);
         main_loop(true);
+
+        // compare the ByteStream backends with small and large stream buffers
+        for (const size_t capacity : {size_t(64 * 1024), size_t(16 * 1024 * 1024)}) {
+            const string cap = to_string(capacity / 1024) + " KiB";
+            TCPConfig config;
+            config.recv_capacity = capacity;
+            config.send_capacity = capacity;
+            config.window_scaling = true;
+            main_loop(false, config, " (buffer list, " + cap + ")");
+            config.stream_backend = ByteStream::Backend::Ring;
+            main_loop(false, config, " (ring, " + cap + ")");
+        }
+
+        // compare the StreamReassembler engines under reordering
+        TCPConfig config;
+        config.reassembler_engine = StreamReassembler::Engine::Bitmap;
+        main_loop(true, config, " (bitmap reassembler)");
+
+        // compare segment sizes: both ends offer the same MSS
+        for (const size_t mss : {size_t(536), size_t(1000), size_t(1460), size_t(8960)}) {
+            TCPConfig mss_config;
+            mss_config.mss = mss;
+            main_loop(false, mss_config, " (mss " + to_string(mss) + ")");
+        }
+
+        // ACK every segment, or every second one (the delayed-ACK timer is shorter than a benchmark round)
+        TCPConfig ack_config;
+        ack_config.delayed_ack = true;
+        main_loop(false, ack_config, " (delayed ACKs)");
+
+        // small writes: one segment each, coalesced by Nagle's algorithm, or by corking each round's writes
+        small_writes_loop({}, false, "");
+        TCPConfig nagle_config;
+        nagle_config.nagle = true;
+        small_writes_loop(nagle_config, false, " (Nagle)");
+        small_writes_loop({}, true, " (cork)");
+        // small writes are copied anyway, so the ring backend gathers them into one contiguous payload
+        nagle_config.stream_backend = ByteStream::Backend::Ring;
+        small_writes_loop(nagle_config, false, " (Nagle, ring)");
+
+        // several losses per window: fast recovery with and without SACK (the timer is set long enough that
+        // only recovery, not a timeout, repairs the holes)
+        for (const bool sack : {false, true}) {
+            TCPConfig loss_config;
+            loss_config.fast_retransmit = true;
+            loss_config.rt_timeout = 10000;
+            loss_config.sack = sack;
+            main_loop(true, loss_config, sack ? " (1 in 20 lost, SACK)" : " (1 in 20 lost, no SACK)", 20);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
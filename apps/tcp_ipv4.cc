@@ -81,6 +81,7 @@ static tuple<TCPConfig, FdAdapterConfig, bool, char *> get_config(int argc, char
         } else if (strncmp("-w", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
+            c_fsm.window_scaling = c_fsm.recv_window_scale() > 0;  // only a window beyond 64 KiB needs it
             curr += 2;
 
         } else if (strncmp("-t", argv[curr], 3) == 0) {
@@ -28,6 +28,10 @@ static void show_usage(const char *argv0, const char *msg) {
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+         << "   -c <algo>       Congestion control: none, newreno or cubic      none\n\n"
+
+         << "   -f              Fast retransmit on duplicate ACKs               (off)\n\n"
+
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
@@ -61,6 +65,7 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
         } else if (strncmp("-w", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
+            c_fsm.window_scaling = c_fsm.recv_window_scale() > 0;  // only a window beyond 64 KiB needs it
             curr += 2;
 
         } else if (strncmp("-t", argv[curr], 3) == 0) {
@@ -68,6 +73,24 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-c", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -c requires one argument.");
+            if (strcmp("none", argv[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionControl::Algorithm::None;
+            } else if (strcmp("newreno", argv[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionControl::Algorithm::NewReno;
+            } else if (strcmp("cubic", argv[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionControl::Algorithm::Cubic;
+            } else {
+                show_usage(argv[0], "ERROR: -c requires none, newreno or cubic.");
+                exit(1);
+            }
+            curr += 2;
+
+        } else if (strncmp("-f", argv[curr], 3) == 0) {
+            c_fsm.fast_retransmit = true;
+            curr += 1;
+
         } else if (strncmp("-Lu", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -Lu requires one argument.");
             float lossrate = strtof(argv[curr + 1], nullptr);
@@ -0,0 +1,126 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 16 * 1024 * 1024;
+constexpr int socket_buffer_size = 16 * 1024 * 1024;
+
+//! Send `len` bytes between two Sponge TCP sockets over UDP on the loopback interface
+//! \param[in] config the configuration of both endpoints
+//! \param[in] loss_rate the probability that each datagram is dropped, in each direction
+void transfer(const TCPConfig &config, const float loss_rate) {
+    // without congestion control, the socket buffers have to hold a whole window of datagrams
+    UDPSocket server_sock, client_sock;
+    server_sock.set_buffer_sizes(socket_buffer_size);
+    client_sock.set_buffer_sizes(socket_buffer_size);
+    server_sock.bind({"127.0.0.1", 0});
+
+    FdAdapterConfig server_ad{};
+    server_ad.source = server_sock.local_address();
+    server_ad.loss_rate_up = server_ad.loss_rate_dn =
+        static_cast<uint16_t>(static_cast<float>(numeric_limits<uint16_t>::max()) * loss_rate);
+
+    FdAdapterConfig client_ad = server_ad;
+    client_ad.source = {"0", 0};
+    client_ad.destination = server_ad.source;
+
+    string data(len, 'x');
+    for (auto &ch : data) {
+        ch = rand();
+    }
+
+    size_t received = 0;
+    thread server_thread([&] {
+        LossyTCPOverUDPSpongeSocket server{LossyTCPOverUDPSocketAdapter{TCPOverUDPSocketAdapter{move(server_sock)}}};
+        server.listen_and_accept(config, server_ad);
+        while (not server.eof()) {
+            received += server.read(65536).size();
+        }
+        server.wait_until_closed();
+    });
+
+    const auto first_time = high_resolution_clock::now();
+    const auto first_system_calls = system_call_count();
+
+    LossyTCPOverUDPSpongeSocket client{LossyTCPOverUDPSocketAdapter{TCPOverUDPSocketAdapter{move(client_sock)}}};
+    client.connect(config, client_ad);
+    client.write(data);
+    client.shutdown(SHUT_WR);
+    server_thread.join();
+
+    const auto final_time = high_resolution_clock::now();
+    const auto system_calls = system_call_count() - first_system_calls;
+    client.wait_until_closed();
+
+    if (received != len) {
+        throw runtime_error("sent " + to_string(len) + " bytes, but received " + to_string(received));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    // 两端所有线程的系统调用，按满载的数据段平摊
+    const double segments = double(len) / TCPConfig::MAX_PAYLOAD_SIZE;
+    cout << fixed << setprecision(2);
+    cout << "Throughput over UDP, window " << setw(8) << config.recv_capacity << " bytes, loss " << setw(4)
+         << loss_rate * 100 << "%, congestion control " << setw(7)
+         << CongestionControl::name(config.congestion_control) << (config.fast_retransmit ? " + fast retransmit" : "")
+         << (config.adaptive_rto ? " + adaptive RTO" : "") << ": " << len * 8.0 / double(duration) << " Gbit/s, "
+         << setw(5) << double(system_calls) / segments << " syscalls/segment\n";
+}
+
+int main() {
+    try {
+        for (const float loss_rate : {0.0f, 0.01f}) {
+            for (const size_t window : {size_t(64000), size_t(256 * 1024), size_t(1024 * 1024)}) {
+                TCPConfig config;
+                config.rt_timeout = 20;
+                config.recv_capacity = window;
+                config.send_capacity = window;
+                config.window_scaling = true;
+                transfer(config, loss_rate);
+            }
+
+            // with a congestion window, a large receive window no longer floods the path after a loss
+            for (const auto algorithm : {CongestionControl::Algorithm::None,
+                                         CongestionControl::Algorithm::NewReno,
+                                         CongestionControl::Algorithm::Cubic}) {
+                TCPConfig config;
+                config.rt_timeout = 20;
+                config.recv_capacity = 1024 * 1024;
+                config.send_capacity = 1024 * 1024;
+                config.window_scaling = true;
+                config.congestion_control = algorithm;
+                config.fast_retransmit = true;
+                transfer(config, loss_rate);
+            }
+
+            // an RTO measured from the path replaces the hand-tuned rt_timeout
+            TCPConfig config;
+            config.recv_capacity = 1024 * 1024;
+            config.send_capacity = 1024 * 1024;
+            config.window_scaling = true;
+            config.congestion_control = CongestionControl::Algorithm::NewReno;
+            config.fast_retransmit = true;
+            config.adaptive_rto = true;
+            config.min_rto = 20;
+            transfer(config, loss_rate);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -20,10 +20,13 @@ void get_URL(const string &host, const string &path) {
     CS144TCPSocket sock;  // lab4
     sock.connect(addr);
 
+    // send the whole request in one segment rather than one per write
+    sock.cork();
     sock.write("GET " + path + " HTTP/1.1\r\n");
     sock.write("Host: " + host + "\r\n");
     sock.write("Connection: close\r\n");
     sock.write("\r\n");
+    sock.uncork();
 
     // If you don’t shut down your outgoing byte stream,
     // the server will wait around for a while for you to send additional requests
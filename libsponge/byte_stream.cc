@@ -1,6 +1,7 @@
 #include "byte_stream.hh"
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 
 // Dummy implementation of a flow-controlled in-memory byte stream.
@@ -12,8 +13,72 @@
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity)
-    : _buffer(), _capacity(capacity), _written_size(0), _read_size(0), _is_end_input(false) {}
+//! \param[in] capacity the maximum number of bytes the stream will buffer
+//! \param[in] backend the storage strategy; Backend::Ring allocates nothing until the first write
+ByteStream::ByteStream(const size_t capacity, const Backend backend)
+    : _backend(backend)
+    , _buffer()
+    , _ring()
+    , _ring_size(0)
+    , _ring_head(0)
+    , _capacity(capacity)
+    , _written_size(0)
+    , _read_size(0)
+    , _is_end_input(false) {}
+
+void ByteStream::_ring_reserve(const size_t size) {
+    if (size <= _ring_size) {
+        return;
+    }
+    // 按需倍增，只分配不清零：只有缓冲过的字节才会被读出，用不到的页也不会被触碰
+    constexpr size_t MIN_RING_SIZE = 4096;
+    const size_t new_size = min(_capacity, max({size, 2 * _ring_size, MIN_RING_SIZE}));
+    unique_ptr<char[]> ring(new char[new_size]);
+    if (buffer_size() > 0) {  // 已缓冲的字节移到新 ring 的开头
+        const size_t first = min(buffer_size(), _ring_size - _ring_head);
+        memcpy(ring.get(), _ring.get() + _ring_head, first);
+        memcpy(ring.get() + first, _ring.get(), buffer_size() - first);
+    }
+    _ring = move(ring);
+    _ring_size = new_size;
+    _ring_head = 0;
+}
+
+void ByteStream::_ring_write(string_view data) {
+    if (data.empty()) {
+        return;
+    }
+    _ring_reserve(buffer_size() + data.size());
+    // 环形缓冲区的写入位置可能需要绕回开头，最多两次 memcpy
+    const size_t tail = (_ring_head + buffer_size()) % _ring_size;
+    const size_t first = min(data.size(), _ring_size - tail);
+    memcpy(_ring.get() + tail, data.data(), first);
+    memcpy(_ring.get(), data.data() + first, data.size() - first);
+}
+
+void ByteStream::_ring_peek(const size_t len, string &out) const {
+    if (len == 0) {
+        return;
+    }
+    // 直接追加，不先把目标字符串清零
+    const size_t first = min(len, _ring_size - _ring_head);
+    out.append(_ring.get() + _ring_head, first);
+    out.append(_ring.get(), len - first);
+}
+
+string ByteStream::_buffer_peek(const size_t len) const {
+    // 只拷贝需要的前缀，而不是把整个缓冲区拼接起来
+    string ret;
+    ret.reserve(len);
+    for (const auto &buf : _buffer.buffers()) {
+        if (ret.size() == len) {
+            break;
+        }
+        const string_view view = buf.str();
+        ret.append(view.substr(0, len - ret.size()));
+    }
+    return ret;
+}
 
 size_t ByteStream::write(const string &data) {
     if (input_ended()) {
@@ -21,7 +86,6 @@ size_t ByteStream::write(const string &data) {
     }
 
     size_t write_size = std::min(data.length(), remaining_capacity());
-    _written_size += write_size;
 
     // 如果 write_size < data.length()，多余的部分会被丢弃
     /* lab0
@@ -30,8 +94,53 @@ size_t ByteStream::write(const string &data) {
     }
     */
     // optimization in lab4
-    string tmp = data.substr(0, write_size);
-    _buffer.append(BufferList(std::move(tmp)));
+    if (_backend == Backend::Ring) {
+        _ring_write(string_view(data).substr(0, write_size));
+    } else if (write_size > 0) {
+        string tmp = data.substr(0, write_size);
+        _buffer.append(BufferList(std::move(tmp)));
+    }
+    _written_size += write_size;
+
+    return write_size;
+}
+
+//! \details If all of `data` fits, the stream adopts its allocation instead of copying it;
+//! only a partial write copies the accepted prefix.
+size_t ByteStream::write(string &&data) {
+    if (input_ended()) {
+        return 0;
+    }
+
+    size_t write_size = std::min(data.length(), remaining_capacity());
+    if (_backend == Backend::Ring) {
+        _ring_write(string_view(data).substr(0, write_size));
+    } else if (write_size == data.length()) {
+        if (write_size > 0) {
+            _buffer.append(BufferList(std::move(data)));
+        }
+    } else if (write_size > 0) {
+        _buffer.append(BufferList(data.substr(0, write_size)));
+    }
+    _written_size += write_size;
+
+    return write_size;
+}
+
+//! \details The stream keeps a reference to the Buffer's storage; a partial write only trims the reference.
+size_t ByteStream::write(Buffer data) {
+    if (input_ended()) {
+        return 0;
+    }
+
+    size_t write_size = std::min(data.size(), remaining_capacity());
+    if (_backend == Backend::Ring) {
+        _ring_write(data.str().substr(0, write_size));
+    } else if (write_size > 0) {
+        data.remove_suffix(data.size() - write_size);
+        _buffer.append(BufferList(std::move(data)));
+    }
+    _written_size += write_size;
 
     return write_size;
 }
@@ -43,21 +152,30 @@ string ByteStream::peek_output(const size_t len) const {
     return std::string(_buffer.begin(), _buffer.begin() + peek_size);
     */
     // optimization in lab4
-    string s = _buffer.concatenate();
-    return string(s.begin(), s.begin() + peek_size);
+    if (_backend == Backend::Ring) {
+        string ret;
+        ret.reserve(peek_size);
+        _ring_peek(peek_size, ret);
+        return ret;
+    }
+    return _buffer_peek(peek_size);
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     size_t pop_size = std::min(len, buffer_size());
-    _read_size += pop_size;
     /* lab0
     while (pop_size--) {
         _buffer.pop_front();
     }
     */
     // optimization in lab4
-    _buffer.remove_prefix(pop_size);
+    if (_backend == Backend::Ring) {
+        _ring_head = pop_size == 0 ? _ring_head : (_ring_head + pop_size) % _ring_size;
+    } else {
+        _buffer.remove_prefix(pop_size);
+    }
+    _read_size += pop_size;
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -69,14 +187,62 @@ std::string ByteStream::read(const size_t len) {
     return data;
 }
 
+//! \param[in] len bytes will be referenced from the output side of the buffer
+//! \note With Backend::Ring the bytes are copied once into a single Buffer, since the ring is overwritten in place.
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    size_t peek_size = std::min(len, buffer_size());
+    if (_backend == Backend::Ring) {
+        return peek_size == 0 ? BufferList{} : BufferList{peek_output(peek_size)};
+    }
+
+    // 复制 Buffer 只增加引用计数，最后一个 Buffer 裁掉多余的尾部
+    BufferList ret;
+    for (const auto &buf : _buffer.buffers()) {
+        if (peek_size == 0) {
+            break;
+        }
+        Buffer slice = buf;
+        if (slice.size() > peek_size) {
+            slice.remove_suffix(slice.size() - peek_size);
+        }
+        peek_size -= slice.size();
+        ret.append(slice);
+    }
+    return ret;
+}
+
+//! \param[in] len bytes will be popped and returned
+BufferList ByteStream::read_buffers(const size_t len) {
+    BufferList data = peek_buffers(len);
+    pop_output(len);
+    return data;
+}
+
+//! \details Unlike read_buffers(), this builds no BufferList (whose std::deque allocates even for one Buffer), so
+//! reading a prefix of a single write allocates nothing.
+//! \param[in] len bytes will be popped and returned
+Buffer ByteStream::read_buffer(const size_t len) {
+    const size_t peek_size = std::min(len, buffer_size());
+    Buffer data;
+    if (_backend == Backend::BufferList && peek_size > 0 && _buffer.buffers().front().size() >= peek_size) {
+        data = _buffer.buffers().front();
+        data.remove_suffix(data.size() - peek_size);
+    } else if (peek_size > 0) {
+        data = Buffer(peek_output(peek_size));
+    }
+    pop_output(peek_size);
+    return data;
+}
+
 void ByteStream::end_input() { _is_end_input = true; }
 
 bool ByteStream::input_ended() const { return _is_end_input; }
 
-size_t ByteStream::buffer_size() const { return _buffer.size(); }
+// BufferList::size() 需要遍历所有 Buffer，这里直接用读写计数得到缓冲区大小
+size_t ByteStream::buffer_size() const { return _written_size - _read_size; }
 
 // bool ByteStream::buffer_empty() const { return _buffer.empty(); } // lab0
-bool ByteStream::buffer_empty() const { return _buffer.size() == 0; }  // optimization in lab4
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }  // optimization in lab4
 
 // eof 成立的条件是 writer 不再写入，同时 reader 读取完全部数据
 bool ByteStream::eof() const { return input_ended() && buffer_empty(); }
@@ -5,7 +5,9 @@
 
 #include <cstddef>
 #include <deque>
+#include <memory>
 #include <string>
+#include <string_view>
 
 //! \brief An in-order byte stream.
 
@@ -13,6 +15,15 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! \brief How the stream stores the bytes that have been written but not yet popped
+    //! \details BufferList never copies a Buffer that is written or read whole, so it is faster for bulk transfers.
+    //! Ring copies every byte in and out, but many small writes come out as one contiguous read.
+    enum class Backend {
+        BufferList,  //!< A list of reference-counted chunks, one per write()
+        Ring,        //!< A contiguous ring, grown on demand up to `capacity` bytes
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -22,7 +33,11 @@ class ByteStream {
     // different approaches.
 
     // std::deque<char> _buffer; // lab0
+    Backend _backend;
     BufferList _buffer;  // optimization in lab4
+    std::unique_ptr<char[]> _ring;  // storage for Backend::Ring, allocated (uninitialized) by the first write
+    size_t _ring_size;              // bytes allocated in `_ring`, doubled as needed up to `_capacity`
+    size_t _ring_head;              // offset in `_ring` of the first unread byte
     size_t _capacity;
     size_t _written_size;
     size_t _read_size;
@@ -30,9 +45,21 @@ class ByteStream {
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    //! Copy `data` into the ring, just after the last buffered byte (the caller checks for room)
+    void _ring_write(std::string_view data);
+
+    //! Make the ring big enough to hold `size` bytes, keeping the buffered ones
+    void _ring_reserve(const size_t size);
+
+    //! Append the first `len` buffered bytes in the ring to `out`
+    void _ring_peek(const size_t len, std::string &out) const;
+
+    //! Copy the first `len` buffered bytes out of the list of chunks
+    std::string _buffer_peek(const size_t len) const;
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Backend backend = Backend::BufferList);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -42,6 +69,14 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of its storage if it all fits.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a Buffer into the stream, sharing its storage rather than copying it.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -66,6 +101,18 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns a BufferList that shares storage with the written data
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Read (i.e., reference and then pop) the next "len" bytes of the stream without copying them
+    //! \returns a BufferList that shares storage with the written data
+    BufferList read_buffers(const size_t len);
+
+    //! Read the next "len" bytes of the stream as one Buffer, copying them only if they span several writes
+    //! \returns a Buffer that shares storage with the written data when it can
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -90,6 +137,9 @@ class ByteStream {
 
     //! Total number of bytes popped
     size_t bytes_read() const;
+
+    //! The storage strategy chosen at construction
+    Backend backend() const { return _backend; }
     //!@}
 };
 
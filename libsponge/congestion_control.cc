@@ -0,0 +1,143 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//! CUBIC's scaling constant, in segments per second cubed
+static constexpr double CUBIC_C = 0.4;
+//! CUBIC's multiplicative decrease factor
+static constexpr double CUBIC_BETA = 0.7;
+
+//! \param[in] algorithm the policy that adjusts the window
+//! \param[in] mss the largest payload the sender puts in one segment
+CongestionControl::CongestionControl(const Algorithm algorithm, const size_t mss)
+    : _algorithm(algorithm), _mss(mss), _cwnd(initial_window()) {}
+
+uint64_t CongestionControl::initial_window() const { return min(10 * _mss, max(2 * _mss, size_t(14600))); }
+
+void CongestionControl::set_mss(const size_t mss) {
+    _mss = mss;
+    _cwnd = initial_window();
+}
+
+void CongestionControl::on_ack(const uint64_t acked_bytes, const uint64_t now) {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    // slow start：每确认一个 segment 的数据，窗口增加至多一个 MSS
+    if (in_slow_start()) {
+        _cwnd += min(acked_bytes, uint64_t(_mss));
+        return;
+    }
+    if (_algorithm == Algorithm::Cubic) {
+        cubic_increase(acked_bytes, now);
+        return;
+    }
+    // congestion avoidance：每确认一整个窗口的数据，窗口增加一个 MSS
+    _bytes_acked += acked_bytes;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void CongestionControl::on_loss(const uint64_t bytes_in_flight, const uint64_t now) {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+    _epoch_start = now;
+}
+
+void CongestionControl::on_duplicate_ack(const unsigned count) {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    _cwnd += count * _mss;
+}
+
+void CongestionControl::on_partial_ack(const uint64_t acked_bytes) {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    // 收缩掉已确认的数据量，至少保留一个 MSS
+    _cwnd -= min(acked_bytes, _cwnd - _mss);
+    if (acked_bytes >= _mss) {
+        _cwnd += _mss;
+    }
+}
+
+void CongestionControl::on_recovery_end() {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    _cwnd = _ssthresh;
+}
+
+//! \details The window drops to one segment, and slow start climbs back to the reduced threshold.
+void CongestionControl::on_timeout(const uint64_t bytes_in_flight, const uint64_t now) {
+    if (_algorithm == Algorithm::None) {
+        return;
+    }
+    reduce(bytes_in_flight);
+    _cwnd = _mss;
+    _epoch_start = now;
+}
+
+//! Set the slow start threshold after a loss, and (for CUBIC) remember the window it happened at
+void CongestionControl::reduce(const uint64_t bytes_in_flight) {
+    _bytes_acked = 0;
+    if (_algorithm == Algorithm::NewReno) {
+        _ssthresh = max(bytes_in_flight / 2, uint64_t(2 * _mss));
+        return;
+    }
+
+    const double cwnd_segments = double(_cwnd) / double(_mss);
+    // fast convergence：窗口比上次丢包时更小，说明有新的流加入，主动让出带宽
+    _w_max = cwnd_segments < _w_max ? cwnd_segments * (1 + CUBIC_BETA) / 2 : cwnd_segments;
+    _ssthresh = max(uint64_t(double(_cwnd) * CUBIC_BETA), uint64_t(2 * _mss));
+    _epoch_started = false;
+}
+
+//! \details Follows the window W_cubic(t) = C (t - K)^3 + W_max, but never grows slower than NewReno would
+//! (the "TCP-friendly region"). t is the time since the epoch began; without an RTT estimate, the
+//! target is not projected one RTT ahead as RFC 9438 suggests.
+void CongestionControl::cubic_increase(const uint64_t acked_bytes, const uint64_t now) {
+    const double cwnd_segments = double(_cwnd) / double(_mss);
+    if (!_epoch_started) {
+        _epoch_started = true;
+        _epoch_start = now;
+        if (_w_max < cwnd_segments) {
+            // 没有发生过丢包（或者窗口已经超过 W_max），从当前窗口开始增长
+            _w_max = cwnd_segments;
+        }
+        _k = cbrt((_w_max - cwnd_segments) / CUBIC_C);
+        _w_est = cwnd_segments;
+    }
+
+    const double t = double(now - _epoch_start) / 1000;
+    const double w_cubic = CUBIC_C * (t - _k) * (t - _k) * (t - _k) + _w_max;
+    _w_est += 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA) * double(acked_bytes) / double(_cwnd);
+
+    const double target = max(w_cubic, _w_est);
+    if (target > cwnd_segments) {
+        // 每个 RTT 至多增长到 target，并且至多增长 50%
+        const double increase = min(target - cwnd_segments, cwnd_segments / 2) * double(acked_bytes) / double(_cwnd);
+        _cwnd += uint64_t(increase * double(_mss));
+    }
+}
+
+string CongestionControl::name(const Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::None:
+            return "none";
+        case Algorithm::NewReno:
+            return "NewReno";
+        case Algorithm::Cubic:
+            return "CUBIC";
+    }
+    return "unknown";
+}
@@ -0,0 +1,90 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//! \brief The congestion window of a TCPSender, and the policy that grows and shrinks it
+//!
+//! The sender reports three events: new data was acknowledged, a loss was detected from duplicate
+//! acknowledgments, and the retransmission timer expired. The policy answers with window(), which
+//! the sender never lets its bytes in flight exceed (in addition to the receiver's window).
+class CongestionControl {
+  public:
+    //! \brief The policy used to adjust the congestion window
+    enum class Algorithm {
+        None,     //!< No congestion window: only the receiver's window limits the sender
+        NewReno,  //!< Slow start, then one segment per window; halved on loss ([RFC 5681](\ref rfc::rfc5681))
+        Cubic,    //!< Grows as a cubic function of the time since the last loss ([RFC 9438](\ref rfc::rfc9438))
+    };
+
+  private:
+    Algorithm _algorithm;
+    size_t _mss;
+
+    uint64_t _cwnd;                  //!< congestion window, in bytes
+    uint64_t _ssthresh{UINT64_MAX};  //!< slow start threshold, in bytes
+    uint64_t _bytes_acked{0};        //!< NewReno: bytes acknowledged since the window last grew by one segment
+
+    //! \name Algorithm::Cubic state, in segments and milliseconds
+    //!@{
+    double _w_max{0};            //!< window just before the last reduction
+    double _w_est{0};            //!< the window NewReno would have reached since the epoch began
+    double _k{0};                //!< seconds it takes the cubic function to grow from the epoch's window to `_w_max`
+    uint64_t _epoch_start{0};    //!< time at which the current congestion avoidance epoch began
+    bool _epoch_started{false};  //!< false until the first ack in congestion avoidance after a reduction
+    //!@}
+
+    uint64_t initial_window() const;
+    void reduce(const uint64_t bytes_in_flight);
+    void cubic_increase(const uint64_t acked_bytes, const uint64_t now);
+
+  public:
+    //! \brief Construct the initial window ([RFC 6928](\ref rfc::rfc6928)) for segments of up to `mss` bytes
+    CongestionControl(const Algorithm algorithm = Algorithm::None, const size_t mss = 1000);
+
+    //! \brief Change the segment size, e.g. once the MSS has been negotiated; resets the initial window
+    void set_mss(const size_t mss);
+
+    //! \brief `acked_bytes` bytes of new data were acknowledged at time `now` (in milliseconds)
+    void on_ack(const uint64_t acked_bytes, const uint64_t now);
+
+    //! \brief A segment was found lost by duplicate acknowledgments (fast retransmit)
+    //! \details Sets the slow start threshold, and the window to it; fast recovery then adjusts the window
+    //! through the three calls below until on_recovery_end().
+    void on_loss(const uint64_t bytes_in_flight, const uint64_t now);
+
+    //! \name Fast recovery ([RFC 6582](\ref rfc::rfc6582) section 3.2)
+    //!@{
+
+    //! \brief `count` duplicate ACKs arrived, each meaning that a segment has left the network
+    //! \details The window is inflated by one MSS per duplicate ACK, so that new data keeps the ACK clock going.
+    void on_duplicate_ack(const unsigned count = 1);
+
+    //! \brief An ACK of `acked_bytes` new bytes arrived that does not end recovery
+    //! \details The window is deflated by the bytes acknowledged, then inflated by one MSS if at least that much was.
+    void on_partial_ack(const uint64_t acked_bytes);
+
+    //! \brief Everything outstanding at the loss has been acknowledged: the window drops back to the threshold
+    void on_recovery_end();
+    //!@}
+
+    //! \brief The retransmission timer expired with `bytes_in_flight` bytes outstanding
+    void on_timeout(const uint64_t bytes_in_flight, const uint64_t now);
+
+    //! \name Accessors
+    //!@{
+
+    //! \returns the congestion window in bytes (UINT64_MAX for Algorithm::None)
+    uint64_t window() const { return _algorithm == Algorithm::None ? UINT64_MAX : _cwnd; }
+    uint64_t ssthresh() const { return _ssthresh; }
+    bool in_slow_start() const { return _cwnd < _ssthresh; }
+    Algorithm algorithm() const { return _algorithm; }
+    //!@}
+
+    //! \returns the name of `algorithm`
+    static std::string name(const Algorithm algorithm);
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
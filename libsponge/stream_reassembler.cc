@@ -7,42 +7,82 @@
 
 // You will need to add private members to the class declaration in `stream_reassembler.hh`
 
+#include <algorithm>
+#include <cstring>
+
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity)
-    : _output(capacity), _capacity(capacity), _unassembled_bytes(0), _is_eof(false), _eof_idx(0), _buffer() {}
+//! \param[in] capacity the maximum number of bytes, reassembled or not, that will be stored
+//! \param[in] backend the storage strategy of the reassembled ByteStream
+//! \param[in] engine the storage strategy for unassembled bytes; Engine::Bitmap allocates everything up front
+StreamReassembler::StreamReassembler(const size_t capacity,
+                                     const ByteStream::Backend backend,
+                                     const Engine engine)
+    : _output(capacity, backend)
+    , _capacity(capacity)
+    , _engine(engine)
+    , _unassembled_bytes(0)
+    , _is_eof(false)
+    , _eof_idx(0)
+    , _buffer()
+    , _ring(engine == Engine::Bitmap ? capacity : 0, '\0')
+    , _bitmap(engine == Engine::Bitmap ? (capacity + 63) / 64 : 0, 0) {}
 
-void StreamReassembler::_buffer_erase(const set<Segment>::iterator &iter) {
-    _unassembled_bytes -= iter->length();
-    _buffer.erase(iter);
+map<size_t, Buffer>::iterator StreamReassembler::_buffer_erase(const map<size_t, Buffer>::iterator &iter) {
+    _unassembled_bytes -= iter->second.size();
+    return _buffer.erase(iter);
 }
 
-void StreamReassembler::_buffer_insert(const Segment &seg) {
+void StreamReassembler::_buffer_insert(Segment &&seg) {
     _unassembled_bytes += seg.length();
-    _buffer.insert(seg);
+    _buffer.emplace(seg._idx, std::move(seg._data));
 }
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // process the input segment
-    if (!data.empty()) {  // data != ""
-        Segment seg{index, data};
-        _handle_substring(seg);
+    if (_engine == Engine::Bitmap) {
+        // Bitmap 引擎总是拷贝进 ring，无需先构造 Buffer
+        _bitmap_push(data, index);
+        _bitmap_assemble();
+        _handle_eof(index + data.length(), eof);
+        return;
     }
+    push_substring(Buffer(string(data)), index, eof);
+}
 
-    // write to 'ByteStream'
-    while (!_buffer.empty() && _buffer.begin()->_idx == _1st_unassembled_idx()) {
-        const auto &iter = _buffer.begin();
-        _output.write(iter->_data);
-        _buffer_erase(iter);
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    const size_t tail = index + data.size();
+
+    if (index == _1st_unassembled_idx() && empty()) {
+        // 快速路径：按序到达且没有等待重组的字节，直接交给 ByteStream（超出容量的部分由 write 截断）
+        _output.write(std::move(data));
+    } else if (_engine == Engine::Bitmap) {
+        _bitmap_push(data, index);
+        _bitmap_assemble();
+    } else {
+        // process the input segment
+        if (data.size() != 0) {
+            Segment seg{index, std::move(data)};
+            _handle_substring(seg);
+        }
+
+        // write to 'ByteStream'
+        while (!_buffer.empty() && _buffer.begin()->first == _1st_unassembled_idx()) {
+            const auto iter = _buffer.begin();
+            _output.write(iter->second);  // 只增加引用计数，不拷贝
+            _buffer_erase(iter);
+        }
     }
 
-    // EOF
+    _handle_eof(tail, eof);
+}
+
+void StreamReassembler::_handle_eof(const size_t tail, const bool eof) {
     if (eof) {
         _is_eof = eof;
-        _eof_idx = index + data.length();
+        _eof_idx = tail;
     }
     if (_is_eof && _1st_unassembled_idx() == _eof_idx) {
         _output.end_input();
@@ -75,7 +115,7 @@ void StreamReassembler::_handle_substring(Segment &seg) {
      *           unacceptable
      */
     if (seg._idx < _1st_unacceptabled_idx() && seg._idx + seg.length() - 1 >= _1st_unacceptabled_idx()) {
-        seg._data = seg._data.substr(0, _1st_unacceptabled_idx() - seg._idx);
+        seg._data.remove_suffix(seg.tail() - _1st_unacceptabled_idx());
     }
 
     /**
@@ -101,7 +141,7 @@ void StreamReassembler::_handle_substring(Segment &seg) {
      *        unassembled
      */
     if (seg._idx < _1st_unassembled_idx() && seg._idx + seg.length() - 1 >= _1st_unassembled_idx()) {
-        seg._data = seg._data.substr(_1st_unassembled_idx() - seg._idx);
+        seg._data.remove_prefix(_1st_unassembled_idx() - seg._idx);
         seg._idx = _1st_unassembled_idx();
     }
 
@@ -109,7 +149,7 @@ void StreamReassembler::_handle_substring(Segment &seg) {
     // seg 可以放入缓冲区中，并与已经存在的 unassembled segments 进行比较。
 
     if (_buffer.empty()) {
-        _buffer_insert(seg);
+        _buffer_insert(std::move(seg));
         return;
     }
 
@@ -117,18 +157,79 @@ void StreamReassembler::_handle_substring(Segment &seg) {
     _handle_overlap(seg);
 }
 
+//! \details Stored segments never overlap each other, so only the segment just before `seg` and the
+//! segments starting inside `seg` can overlap it; they are found with upper_bound() in O(log n).
+//! Stored bytes are never rebuilt: `seg` is trimmed to the bytes not yet stored, and stored segments
+//! that it completely covers are dropped.
 void StreamReassembler::_handle_overlap(Segment &seg) {
-    // 从头遍历 O(n)，可以考虑使用 upper_bound() 二分查找 O(logn) 优化一下
-    for (auto iter = _buffer.begin(); iter != _buffer.end();) {
-        size_t seg_tail = seg._idx + seg.length() - 1;
-        size_t cache_tail = iter->_idx + iter->length() - 1;
-
-        if ((seg._idx >= iter->_idx && seg._idx <= cache_tail) || (iter->_idx >= seg._idx && iter->_idx <= seg_tail)) {
-            _merge_seg(seg, *iter);  // 先消除重叠：把传入的 seg 与已缓存并存在重叠的 segment 合并,
-            _buffer_erase(iter++);   // 合并后先删除已存在的 segment
-        } else {
-            ++iter;
+    auto iter = _buffer.upper_bound(seg._idx);
+
+    /**
+     * @brief seg 头部与前一个已缓存的 segment 重合，裁切 seg 头部
+     *
+     *               seg        seg
+     *               index      tail
+     *                 ├──────────┤
+     *                 │//////////│
+     *             ┌───┴─────┬────┘
+     *             │         │
+     *         ────┼─────────┼──────────►
+     *         stored      stored
+     *     segment index  segment tail
+     */
+    if (iter != _buffer.begin()) {
+        const auto prev = std::prev(iter);
+        const size_t prev_tail = prev->first + prev->second.size();
+        if (prev_tail >= seg.tail()) {
+            return;  // seg 所包含的字节内容已经存在于缓冲区中
+        }
+        if (prev_tail > seg._idx) {
+            seg._data.remove_prefix(prev_tail - seg._idx);
+            seg._idx = prev_tail;
+        }
+    }
+
+    // 之后的 segment 都从 seg 内部开始
+    while (iter != _buffer.end() && iter->first < seg.tail()) {
+        const size_t cache_tail = iter->first + iter->second.size();
+
+        /**
+         * @brief seg 完全覆盖已缓存的 segment，删除已缓存的 segment
+         *
+         *       seg               seg
+         *       index             tail
+         *         ├─────────────────┤
+         *         │/////////////////│
+         *         └───┬─────────┬───┘
+         *             │         │
+         *         ────┼─────────┼─────────►
+         *         stored      stored
+         *     segment index  segment tail
+         */
+        if (cache_tail <= seg.tail()) {
+            iter = _buffer_erase(iter);
+            continue;
         }
+
+        /**
+         * @brief seg 尾部与已缓存的 segment 重合，裁切 seg 尾部
+         *
+         *   seg           seg
+         *   index         tail
+         *     ├────────────┤
+         *     │////////////│
+         *     └──────┬─────┴───┐
+         *            │         │
+         *        ────┼─────────┼───────►
+         *        stored      stored
+         *    segment index  segment tail
+         */
+        seg._data.remove_suffix(seg.tail() - iter->first);
+        break;
+    }
+
+    if (seg.length() == 0) {
+        return;
     }
 
     /**
@@ -138,81 +239,165 @@ void StreamReassembler::_handle_overlap(Segment &seg) {
      *     ┌─────┐  ├─────────┤   ┌────────┐
      *   ──┴─────┴──┴─────────┴───┴────────┴────►
      */
-    _buffer_insert(seg);  // 把处理完重叠并合并后的 seg 插入缓冲区
+    _buffer_insert(std::move(seg));
 }
 
-void StreamReassembler::_merge_seg(Segment &seg, const Segment &cache) {
-    size_t seg_tail = seg._idx + seg.length() - 1;
-    size_t cache_tail = cache._idx + cache.length() - 1;
+//! \details Copies the acceptable part of `data` into the ring (at most two memcpy's) and marks it present.
+//! Bytes that are already present are simply overwritten with the same values.
+void StreamReassembler::_bitmap_push(string_view data, const size_t index) {
+    // 与 _handle_substring() 相同的边界检查，只是直接计算下标
+    const size_t first = max(index, _1st_unassembled_idx());
+    const size_t last = min(index + data.size(), _1st_unacceptabled_idx());
+    if (first >= last) {
+        return;
+    }
+    data = data.substr(first - index, last - first);
+
+    const size_t pos = first % _capacity;
+    const size_t head = min(data.size(), _capacity - pos);  // 不绕回的部分
+    memcpy(_ring.data() + pos, data.data(), head);
+    memcpy(_ring.data(), data.data() + head, data.size() - head);
+    _unassembled_bytes += _bitmap_set(pos, pos + head) + _bitmap_set(0, data.size() - head);
+}
 
-    /**
-     * @brief seg 尾部与已缓存的 segment 重合，裁切 seg 尾部再合并
-     *
-     *   seg           seg
-     *   index         tail
-     *     ├────────────┤             ┌──────────┐
-     *     │////////////│             │//////////│
-     *     └──────┬─────┴───┐         └─┬────────┤
-     *            │         │           │        │
-     *        ────┼─────────┼───────────┴────────┴───►
-     *        stored   1   stored           2
-     *    segment index   segment tail
-     */
-    if (seg._idx < cache._idx && seg_tail <= cache_tail) {
-        seg._data = seg._data.substr(0, cache._idx - seg._idx) + cache._data;
+//! \details Finds the run of present bytes starting at the first unassembled index and writes it to the stream.
+void StreamReassembler::_bitmap_assemble() {
+    if (_unassembled_bytes == 0) {
+        return;
     }
-    /**
-     * @brief seg 头部与已缓存的 segment 重合，裁切 seg 头部再合并
-     *
-     *               seg        seg
-     *               index      tail
-     *                 ├──────────┤      ┌─────────────┐
-     *                 │//////////│      │/////////////│
-     *             ┌───┴─────┬────┘      ├─────────┬───┘
-     *             │         │           │         │
-     *         ────┼─────────┼───────────┴─────────┴─────────────►
-     *         stored   1    stored           2
-     *     segment index   segment tail
-     */
-    else if (seg._idx >= cache._idx && seg_tail > cache_tail) {
-        seg._data = cache._data + seg._data.substr(cache._idx + cache.length() - seg._idx);
-        seg._idx = cache._idx;
+    const size_t pos = _1st_unassembled_idx() % _capacity;
+    size_t len = _bitmap_run(pos, _capacity);
+    if (len == _capacity - pos) {
+        len += _bitmap_run(0, pos);  // 绕回开头继续查找
     }
-    /**
-     * @brief seg 所包含的字节内容已经存在于缓冲区中。
-     *
-     *         seg       seg
-     *         index     tail
-     *           ├────────┤         ┌─────┐           ┌────┐  ┌───────┐
-     *           │////////│         │/////│           │////│  │///////│
-     *       ┌───┴────────┴───┐     ├─────┴────┐  ┌───┴────┤  ├───────┤
-     *       │                │     │          │  │        │  │       │
-     *     ──┼────────────────┼─────┴──────────┴──┴────────┴──┴───────┴───►
-     *    stored      1     stored       2            3          4
-     *   segment index    segment tail
-     */
-    else if (seg._idx >= cache._idx && seg_tail <= cache_tail) {
-        seg._data = cache._data;
-        seg._idx = cache._idx;
+    if (len == 0) {
+        return;
     }
-    /**
-     * @brief seg 中部与已经缓存的 segment 重合
-     *
-     *       seg               seg
-     *       index             tail
-     *         ├─────────────────┤   ┌─────────────────┐
-     *         │/////////////////│   │/////////////////│
-     *         └───┬─────────┬───┘   └─┬───┬───┬───┬───┘
-     *             │         │         │   │   │   │
-     *         ────┼─────────┼─────────┴───┴───┴───┴───►
-     *         stored   1   stored           2
-     *     segment index   segment tail
-     */
-    // else if (seg._idx < cache._idx && seg_tail > cache_tail) {
-    // do nothing
-    // }
+
+    const size_t head = min(len, _capacity - pos);
+    string assembled;
+    assembled.reserve(len);
+    assembled.append(_ring, pos, head);
+    assembled.append(_ring, 0, len - head);
+    _bitmap_clear(pos, pos + head);
+    _bitmap_clear(0, len - head);
+    _unassembled_bytes -= len;
+    _output.write(std::move(assembled));
+}
+
+//! \param[in] first the first bit to set
+//! \param[in] last one past the last bit to set (must not exceed `_capacity`)
+size_t StreamReassembler::_bitmap_set(size_t first, const size_t last) {
+    size_t newly_set = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+        uint64_t &word = _bitmap[first / 64];
+        newly_set += __builtin_popcountll(mask & ~word);
+        word |= mask;
+        first += n;
+    }
+    return newly_set;
+}
+
+//! \param[in] first the first bit to clear
+//! \param[in] last one past the last bit to clear (must not exceed `_capacity`)
+void StreamReassembler::_bitmap_clear(size_t first, const size_t last) {
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+        _bitmap[first / 64] &= ~mask;
+        first += n;
+    }
+}
+
+//! \param[in] first the first bit to examine
+//! \param[in] last one past the last bit to examine (must not exceed `_capacity`)
+//! \details Scans a word at a time, using count-trailing-zeros to find the first missing byte.
+size_t StreamReassembler::_bitmap_run(size_t first, const size_t last) const {
+    size_t run = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t missing = ~_bitmap[first / 64] >> bit;
+        if (missing != 0) {
+            const size_t present = __builtin_ctzll(missing);
+            if (present < n) {
+                return run + present;
+            }
+        }
+        run += n;
+        first += n;
+    }
+    return run;
+}
+
+//! \param[in] first the first bit to examine
+//! \param[in] last one past the last bit to examine (must not exceed `_capacity`)
+size_t StreamReassembler::_bitmap_gap(size_t first, const size_t last) const {
+    size_t gap = 0;
+    while (first < last) {
+        const size_t bit = first % 64;
+        const size_t n = min(64 - bit, last - first);
+        const uint64_t present = _bitmap[first / 64] >> bit;
+        if (present != 0) {
+            const size_t missing = __builtin_ctzll(present);
+            if (missing < n) {
+                return gap + missing;
+            }
+        }
+        gap += n;
+        first += n;
+    }
+    return gap;
+}
+
+//! \details `limit - index` must not exceed `_capacity`, so the scan wraps around the ring at most once.
+size_t StreamReassembler::_bitmap_extent(const size_t index, const size_t limit, const bool present) const {
+    const size_t pos = index % _capacity;
+    const size_t head = min(limit - index, _capacity - pos);
+    const auto scan = [&](const size_t first, const size_t last) {
+        return present ? _bitmap_run(first, last) : _bitmap_gap(first, last);
+    };
+    size_t extent = scan(pos, pos + head);
+    if (extent == head) {
+        extent += scan(0, limit - index - head);  // 绕回开头继续查找
+    }
+    return extent;
+}
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::buffered_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (_unassembled_bytes == 0) {
+        return ranges;
+    }
+    if (_engine == Engine::Bitmap) {
+        // 交替查找空洞与连续的已存储字节
+        const size_t limit = _1st_unacceptabled_idx();
+        size_t index = _1st_unassembled_idx();
+        while (index < limit) {
+            index += _bitmap_extent(index, limit, false);
+            if (index == limit) {
+                break;
+            }
+            const size_t run = _bitmap_extent(index, limit, true);
+            ranges.emplace_back(index, index + run);
+            index += run;
+        }
+        return ranges;
+    }
+    for (const auto &[index, data] : _buffer) {
+        if (!ranges.empty() && ranges.back().second == index) {
+            ranges.back().second += data.size();  // 与前一段相邻，合并
+        } else {
+            ranges.emplace_back(index, index + data.size());
+        }
+    }
+    return ranges;
 }
 
 size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
 
-bool StreamReassembler::empty() const { return _buffer.empty(); }
+bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
@@ -4,23 +4,33 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
-#include <set>
+#include <map>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! \brief How the StreamReassembler stores the bytes that have not yet been assembled
+    enum class Engine {
+        SortedMap,  //!< Non-overlapping Buffer slices of the pushed data, in a map keyed by index
+        Bitmap,     //!< A preallocated ring of `capacity` bytes plus a bitmap of which bytes are present
+    };
+
   private:
+    //! A stored substring: the index of its first byte, and its bytes (which share storage with the pushed data)
     struct Segment {
         size_t _idx;
-        std::string _data;
+        Buffer _data;
 
         Segment() : _idx(0), _data() {}
-        Segment(size_t index, const std::string &data) : _idx(index), _data(data) {}
+        Segment(size_t index, Buffer data) : _idx(index), _data(std::move(data)) {}
 
-        size_t length() const { return _data.length(); }
-
-        bool operator<(const Segment &seg) const { return this->_idx < seg._idx; }
+        size_t length() const { return _data.size(); }
+        size_t tail() const { return _idx + length(); }  //!< index just past the last byte
     };
 
   private:
@@ -28,19 +38,37 @@ class StreamReassembler {
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
+    Engine _engine;
 
     size_t _unassembled_bytes;  // unassembled but stored bytes
     bool _is_eof;
     size_t _eof_idx;
 
-    std::set<Segment> _buffer;
-    void _buffer_erase(const std::set<Segment>::iterator &iter);
-    void _buffer_insert(const Segment &seg);
+    //! Stored, non-overlapping segments keyed by the index of their first byte
+    std::map<size_t, Buffer> _buffer;
+    std::map<size_t, Buffer>::iterator _buffer_erase(const std::map<size_t, Buffer>::iterator &iter);
+    void _buffer_insert(Segment &&seg);
 
     // 处理乱序、重叠的字符串片段，并尝试放入缓冲区中
     void _handle_substring(Segment &seg);
     void _handle_overlap(Segment &seg);
-    void _merge_seg(Segment &seg, const Segment &cache);
+
+    //! Record the end of the stream if `eof`, and end the output once every byte before it is assembled
+    void _handle_eof(const size_t tail, const bool eof);
+
+    //! \name Engine::Bitmap state: the byte at stream index `i` lives at `_ring[i % _capacity]`
+    //!@{
+    std::string _ring;              //!< bytes that have been pushed but not yet assembled
+    std::vector<uint64_t> _bitmap;  //!< bit `i % _capacity` is set if the byte at index `i` is in `_ring`
+    void _bitmap_push(std::string_view data, const size_t index);
+    void _bitmap_assemble();
+    size_t _bitmap_set(size_t first, const size_t last);        //!< \returns the number of newly set bits
+    void _bitmap_clear(size_t first, const size_t last);
+    size_t _bitmap_run(size_t first, const size_t last) const;  //!< \returns the number of leading set bits
+    size_t _bitmap_gap(size_t first, const size_t last) const;  //!< \returns the number of leading clear bits
+    //! \returns the number of bytes from stream index `index` (up to `limit`) that are all present or all missing
+    size_t _bitmap_extent(const size_t index, const size_t limit, const bool present) const;
+    //!@}
 
     size_t _1st_unread_idx() const { return _output.bytes_read(); }
     size_t _1st_unassembled_idx() const { return _output.bytes_written(); }
@@ -50,7 +78,9 @@ class StreamReassembler {
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity,
+                      const ByteStream::Backend backend = ByteStream::Backend::BufferList,
+                      const Engine engine = Engine::SortedMap);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -62,6 +92,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, sharing its storage rather than copying it.
+    //!
+    //! A substring that starts at the first unassembled index while nothing else is waiting
+    //! is written straight to the stream, which only costs a reference count.
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -74,9 +110,17 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The stored but unassembled bytes, as [first, last) ranges of stream indices in ascending order
+    //! \details Adjacent stored substrings are merged into one range. These are the blocks a receiver reports
+    //! with selective acknowledgments.
+    std::vector<std::pair<uint64_t, uint64_t>> buffered_ranges() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
+
+    //! The storage strategy chosen at construction
+    Engine engine() const { return _engine; }
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -23,18 +25,30 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
     _time_since_last_segment_received = 0;
 
+    // 大多数 segment 可以走 header prediction 的快速路径
+    if (predicted_segment_received(seg)) {
+        _predicted_segments++;
+        return;
+    }
+
     // 接收到 RST 标识
     if (seg.header().rst) {
         unclean_shutdown();
         return;
     }
 
+    // 对方的第一个 SYN：协商 MSS 与 window scale
+    if (seg.header().syn && !_receiver.ackno().has_value()) {
+        negotiate_options(seg.header());
+    }
+
     // 交给接收器
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
+    const bool had_gap = _receiver.unassembled_bytes() > 0;
     _receiver.segment_received(seg);
 
     // 服务端在 LISTEN 状态接收到了 SYN
-    if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::SYN_RECV &&
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::CLOSED) {
+    if (_state == TCPState::State::LISTEN && _receiver.ackno().has_value() && !_receiver.stream_out().input_ended()) {
         // 进行三次握手中的第二次，发送 SYN + ACK
         connect();
         return;
@@ -42,12 +56,21 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     // 接收到 ACK 标识，通知发送器更新
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        // SYN 中的窗口不进行缩放
+        const uint64_t window = seg.header().syn ? seg.header().win : uint64_t{seg.header().win} << _snd_wscale;
+        if (_sack_enabled && !seg.header().sack.empty()) {
+            _sender.sack_received(seg.header().sack);
+        }
+        _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() == 0);
+    }
+    if (_state == TCPState::State::SYN_SENT || _state == TCPState::State::SYN_RCVD) {
+        handshake_progressed();
     }
     // _sender.fill_window(); // ack_received() 中已经调用
 
-    // 至少发送一个 segment 作为回复
-    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty()) {
+    // 至少发送一个 segment 作为回复（也可以推迟，见 ack_immediately()）
+    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty() &&
+        ack_immediately(seg, ackno_before, had_gap)) {
         _sender.send_empty_segment();
     }
 
@@ -68,10 +91,28 @@ size_t TCPConnection::write(const string &data) {
     if (!_is_active || data.empty()) {
         return 0;
     }
-    size_t n = _sender.stream_in().write(data);
+    return send_written(_sender.stream_in().write(data));
+}
+
+size_t TCPConnection::write(string &&data) {
+    if (!_is_active || data.empty()) {
+        return 0;
+    }
+    return send_written(_sender.stream_in().write(std::move(data)));
+}
+
+size_t TCPConnection::write(Buffer data) {
+    if (!_is_active || data.size() == 0) {
+        return 0;
+    }
+    return send_written(_sender.stream_in().write(std::move(data)));
+}
+
+// 写入 outbound stream 之后尽可能发送数据
+size_t TCPConnection::send_written(const size_t bytes_written) {
     _sender.fill_window();
     send_segments();
-    return n;
+    return bytes_written;
 }
 
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
@@ -82,6 +123,13 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     // 告知时间
     _sender.tick(ms_since_last_tick);
     _time_since_last_segment_received += ms_since_last_tick;
+    // 推迟的 ACK 到期（重传的片段也会携带 ACK）
+    if (_segments_unacked > 0) {
+        _time_since_ack_delayed += ms_since_last_tick;
+        if (_time_since_ack_delayed >= _cfg.ack_delay && _sender.segments_out().empty()) {
+            _sender.send_empty_segment();
+        }
+    }
     // 超出限制则终止连接
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
         send_rst_segment();  // 空或者非空 segment 似乎都行
@@ -94,6 +142,27 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     clean_shutdown();
 }
 
+//! \details The earliest of the retransmission timeout, the delayed ACK and the end of TIME_WAIT. Ticks before then
+//! only count time, so an owner with many connections can leave idle ones alone until this deadline (and tell them
+//! the elapsed time before anything else).
+optional<size_t> TCPConnection::time_until_next_timeout() const {
+    if (!_is_active) {
+        return {};
+    }
+    optional<size_t> next = _sender.time_until_timeout();
+    const auto at_most = [&](const size_t limit, const size_t elapsed) {
+        const size_t remaining = limit > elapsed ? limit - elapsed : 0;
+        next = min(next.value_or(remaining), remaining);
+    };
+    if (_segments_unacked > 0) {
+        at_most(_cfg.ack_delay, _time_since_ack_delayed);
+    }
+    if (_state == TCPState::State::TIME_WAIT && _linger_after_streams_finish) {
+        at_most(10 * _cfg.rt_timeout, _time_since_last_segment_received);
+    }
+    return next;
+}
+
 void TCPConnection::end_input_stream() {
     _sender.stream_in().end_input();
     // 结束流，发送 FIN 报文
@@ -101,6 +170,14 @@ void TCPConnection::end_input_stream() {
     send_segments();
 }
 
+void TCPConnection::uncork() {
+    if (!_is_active) {
+        return;
+    }
+    _sender.uncork();
+    send_segments();
+}
+
 void TCPConnection::connect() {  // 用于三次握手
     _sender.fill_window();
     send_segments();
@@ -124,14 +201,133 @@ void TCPConnection::send_segments() {
     while (!_sender.segments_out().empty()) {
         TCPSegment seg = _sender.segments_out().front();
         _sender.segments_out().pop();
-        if (_receiver.ackno().has_value()) {
-            seg.header().ack = true;
-            seg.header().ackno = _receiver.ackno().value();
-            seg.header().win = _receiver.window_size() <= numeric_limits<uint16_t>::max()
-                                   ? _receiver.window_size()
-                                   : numeric_limits<uint16_t>::max();
+        set_ack_and_window(seg);
+        if (seg.header().syn || seg.header().fin) {
+            segment_sent(seg.header());
         }
         _segments_out.push(seg);
+        if (seg.header().ack) {
+            _segments_unacked = 0;
+            _time_since_ack_delayed = 0;
+        }
+    }
+}
+
+//! \details With delayed ACKs (RFC 1122 section 4.2.3.2, RFC 5681 section 4.2), an ACK for in-order data is held
+//! back until `ack_every` data segments have arrived or `ack_delay` milliseconds have passed, and is dropped if an
+//! outgoing segment carries it first. Segments that are out of order, fill a gap, or carry SYN or FIN are still
+//! ACKed at once, so the peer's fast retransmit and connection teardown are not slowed down.
+//! \param[in] ackno the receiver's ackno before `seg` arrived
+//! \param[in] had_gap whether the receiver held out-of-order data before `seg` arrived
+bool TCPConnection::ack_immediately(const TCPSegment &seg,
+                                    const optional<WrappingInt32> &ackno,
+                                    const bool had_gap) {
+    if (!_cfg.delayed_ack || seg.header().syn || seg.header().fin || had_gap) {
+        return true;
+    }
+    if (!ackno.has_value() || seg.header().seqno != ackno.value() || _receiver.unassembled_bytes() > 0) {
+        return true;
+    }
+    if (++_segments_unacked >= _cfg.ack_every) {
+        return true;
+    }
+    if (_segments_unacked == 1) {
+        _time_since_ack_delayed = 0;
+    }
+    return false;
+}
+
+//! \details Header prediction (Van Jacobson; see RFC 1323, section 4.2): most segments of a connection either
+//! carry the next in-order data and acknowledge nothing new ("pure data"), or carry no data and acknowledge new
+//! data ("pure ACK"). Pure data cannot change the state before the peer's FIN has arrived, and a pure ACK cannot
+//! before our own stream has ended, so such segments skip the RST and SYN handling, the receiver's sequence number
+//! arithmetic and the shutdown and state checks. Pure data also skips the sender, so it must leave the window as
+//! it was. This covers ESTABLISHED, and also a one-way transfer after the other direction has closed. Anything
+//! else takes the general path.
+//! \returns false, having done nothing, if `seg` is not one of the predicted kinds
+bool TCPConnection::predicted_segment_received(const TCPSegment &seg) {
+    const TCPHeader &header = seg.header();
+    if (!header.ack || header.syn || header.fin || header.rst || header.urg || !header.sack.empty()) {
+        return false;
+    }
+    const bool pure_ack = seg.payload().size() == 0;
+    if (pure_ack && ((_state != TCPState::State::ESTABLISHED && _state != TCPState::State::CLOSE_WAIT) ||
+                     _sender.stream_in().input_ended())) {
+        return false;
+    }
+    if (!pure_ack && _state != TCPState::State::ESTABLISHED && _state != TCPState::State::FIN_WAIT_1 &&
+        _state != TCPState::State::FIN_WAIT_2) {
+        return false;
+    }
+    const WrappingInt32 ackno = _receiver.ackno().value();
+    const uint64_t window = uint64_t{header.win} << _snd_wscale;
+    if (header.seqno != ackno) {
+        return false;
+    }
+
+    if (pure_ack) {
+        // 纯 ACK：确认了新的数据，且不在 fast recovery 中
+        const WrappingInt32 una = _sender.unacknowledged_seqno();
+        const WrappingInt32 next = _sender.next_seqno();
+        if (header.ackno - una <= 0 || header.ackno - next > 0 || _sender.in_fast_recovery()) {
+            return false;
+        }
+        _sender.ack_received(header.ackno, window, true);
+    } else {
+        // 纯数据：没有确认新的数据，窗口不变（所以不必交给发送器），没有乱序缓存，且窗口放得下
+        if (header.ackno != _sender.unacknowledged_seqno() || window == 0 || window != _sender.window_size() ||
+            _receiver.unassembled_bytes() > 0 || seg.payload().size() > _receiver.window_size()) {
+            return false;
+        }
+        _receiver.in_order_payload_received(seg.payload());
+        if (_sender.segments_out().empty() && ack_immediately(seg, ackno, false)) {
+            _sender.send_empty_segment();
+        }
+    }
+
+    send_segments();
+    // 填上了之前乱序到达的 FIN 前面的空洞
+    if (_receiver.stream_out().input_ended()) {
+        clean_shutdown();
+    }
+    return true;
+}
+
+//! \details The MSS we send with is the smaller of ours and the peer's; if the peer did not send the option,
+//! ours is used (rather than the 536 bytes of RFC 9293). Window scaling and SACK are only in effect if both SYNs
+//! carry them.
+void TCPConnection::negotiate_options(const TCPHeader &syn_header) {
+    if (syn_header.mss.has_value() && syn_header.mss.value() > 0) {
+        _sender.set_max_payload_size(min<size_t>(_cfg.mss, syn_header.mss.value()));
+    }
+    if (_cfg.window_scaling && syn_header.wscale.has_value()) {
+        _peer_wscale = min(syn_header.wscale.value(), TCPConfig::MAX_WINDOW_SCALE);
+        _snd_wscale = _peer_wscale.value();
+        _rcv_wscale = _cfg.recv_window_scale();
+    }
+    _sack_enabled = _cfg.sack && syn_header.sack_permitted;
+}
+
+// 填写 ackno 与窗口；SYN 还要携带 MSS、window scale 与 SACK permitted 选项，其余 ACK 携带 SACK blocks
+void TCPConnection::set_ack_and_window(TCPSegment &seg) {
+    if (_receiver.ackno().has_value()) {
+        const size_t window = seg.header().syn ? _receiver.window_size() : _receiver.window_size() >> _rcv_wscale;
+        seg.header().ack = true;
+        seg.header().ackno = _receiver.ackno().value();
+        seg.header().win = min<size_t>(window, numeric_limits<uint16_t>::max());
+    }
+    if (seg.header().syn) {
+        seg.header().mss = min<size_t>(_cfg.mss, numeric_limits<uint16_t>::max());
+    }
+    // 主动打开时总是提供 window scale；被动打开时只有对方提供了才回应
+    if (seg.header().syn && _cfg.window_scaling && (!_receiver.ackno().has_value() || _peer_wscale.has_value())) {
+        seg.header().wscale = _cfg.recv_window_scale();
+    }
+    if (seg.header().syn && _cfg.sack && (!_receiver.ackno().has_value() || _sack_enabled)) {
+        seg.header().sack_permitted = true;
+    }
+    if (!seg.header().syn && seg.header().ack && _sack_enabled) {
+        seg.header().sack = _receiver.sack_blocks();
     }
 }
 
@@ -143,32 +339,93 @@ void TCPConnection::send_rst_segment() {
 
     TCPSegment seg = _sender.segments_out().front();
     _sender.segments_out().pop();
-    if (_receiver.ackno().has_value()) {
-        seg.header().ack = true;
-        seg.header().ackno = _receiver.ackno().value();
-        seg.header().win = _receiver.window_size() <= numeric_limits<uint16_t>::max() ? _receiver.window_size()
-                                                                                      : numeric_limits<uint16_t>::max();
-    }
+    set_ack_and_window(seg);
     seg.header().rst = true;
     _segments_out.push(seg);
 }
 
+//! \details Called after every received segment and tick. Only the current state's transitions are checked:
+//! the peer's FIN (passive close, CLOSING, TIME-WAIT), the ACK of our FIN, and the end of TIME-WAIT.
 void TCPConnection::clean_shutdown() {
     // 输入流在输出流到达 EOF 之前结束（服务端）
     if (_receiver.stream_out().input_ended() && !_sender.stream_in().eof()) {
         _linger_after_streams_finish = false;
     }
-    // 客户端处在 TIME-WAIT 时
-    else if (TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED &&
-             TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV) {
-        if (!_linger_after_streams_finish || _time_since_last_segment_received >= 10 * _cfg.rt_timeout) {
-            _is_active = false;
+    // FIN 已发出时，没有在途的字节就说明 FIN 已被确认
+    const bool fin_acked = _sender.bytes_in_flight() == 0;
+    switch (_state) {
+        case TCPState::State::FIN_WAIT_1:
+            if (fin_acked) {
+                _state = TCPState::State::FIN_WAIT_2;
+            }
+            break;
+        case TCPState::State::CLOSING:
+            if (fin_acked) {
+                _state = TCPState::State::TIME_WAIT;
+            }
+            break;
+        case TCPState::State::LAST_ACK:
+            // 被动关闭的一方不需要等待
+            if (fin_acked) {
+                _is_active = false;
+                _state = TCPState::State::CLOSED;
+            }
+            return;
+        default:
+            break;
+    }
+    if (_receiver.stream_out().input_ended()) {
+        switch (_state) {
+            case TCPState::State::ESTABLISHED:
+                if (!_linger_after_streams_finish) {
+                    _state = TCPState::State::CLOSE_WAIT;
+                }
+                break;
+            case TCPState::State::FIN_WAIT_1:
+                _state = TCPState::State::CLOSING;
+                break;
+            case TCPState::State::FIN_WAIT_2:
+                _state = TCPState::State::TIME_WAIT;
+                break;
+            default:
+                break;
         }
     }
+    // 客户端处在 TIME-WAIT 时，等待 10 倍 RTO 后关闭
+    if (_state == TCPState::State::TIME_WAIT && _time_since_last_segment_received >= 10 * _cfg.rt_timeout) {
+        _is_active = false;
+        _state = TCPState::State::CLOSED;
+    }
 }
 
 void TCPConnection::unclean_shutdown() {
     _sender.stream_in().set_error();
     _receiver.stream_out().set_error();
     _is_active = false;
+    _state = TCPState::State::RESET;
+}
+
+// 收到对方的 SYN（同时打开时没有 ACK），或者我们的 SYN 被确认
+void TCPConnection::handshake_progressed() {
+    if (_state == TCPState::State::SYN_SENT && _receiver.ackno().has_value()) {
+        _state = TCPState::State::SYN_RCVD;
+    }
+    const bool syn_acked = _sender.next_seqno_absolute() > _sender.bytes_in_flight();
+    if (_state == TCPState::State::SYN_RCVD && syn_acked) {
+        // SYN 被确认之前已经收到了 FIN
+        _state = _receiver.stream_out().input_ended() && !_linger_after_streams_finish ? TCPState::State::CLOSE_WAIT
+                                                                                       : TCPState::State::ESTABLISHED;
+    }
+}
+
+// 发出 SYN 或 FIN 时的状态转移（重传不改变状态）
+void TCPConnection::segment_sent(const TCPHeader &header) {
+    if (header.syn && _state == TCPState::State::LISTEN) {
+        _state = _receiver.ackno().has_value() ? TCPState::State::SYN_RCVD : TCPState::State::SYN_SENT;
+    }
+    if (header.fin && _state == TCPState::State::ESTABLISHED) {
+        _state = _receiver.stream_out().input_ended() ? TCPState::State::CLOSING : TCPState::State::FIN_WAIT_1;
+    } else if (header.fin && _state == TCPState::State::CLOSE_WAIT) {
+        _state = TCPState::State::LAST_ACK;
+    }
 }
@@ -10,8 +10,8 @@
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.stream_backend, _cfg.reassembler_engine};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -25,11 +25,41 @@ class TCPConnection {
     size_t _time_since_last_segment_received{0};
     bool _is_active{true};
 
+    //! \name Window scaling (RFC 7323): both shifts stay 0 unless both SYNs carried the window scale option
+    //!@{
+    std::optional<uint8_t> _peer_wscale{};  //!< the shift the peer offered in its SYN
+    uint8_t _snd_wscale{0};                 //!< applied to the windows the peer advertises
+    uint8_t _rcv_wscale{0};                 //!< applied to the windows we advertise
+    //!@}
+
+    //! both SYNs carried the SACK-permitted option, so ACKs carry SACK blocks in both directions
+    bool _sack_enabled{false};
+
+    //! \name Delayed ACKs: data segments received since the last ACK we sent, and for how long one has been due
+    //!@{
+    size_t _segments_unacked{0};
+    size_t _time_since_ack_delayed{0};
+    //!@}
+
+    //! the "official" TCP state, set at its transitions: SYN or FIN sent, SYN or FIN received, our SYN or FIN
+    //! acknowledged, the end of TIME-WAIT, and RST
+    TCPState::State _state{TCPState::State::LISTEN};
+
+    //! received segments that took the header-prediction fast path
+    size_t _predicted_segments{0};
+
     void send_segments();
     void send_rst_segment();
+    void set_ack_and_window(TCPSegment &seg);
+    void negotiate_options(const TCPHeader &syn_header);
+    size_t send_written(const size_t bytes_written);
+    bool ack_immediately(const TCPSegment &seg, const std::optional<WrappingInt32> &ackno, const bool had_gap);
+    bool predicted_segment_received(const TCPSegment &seg);
 
     void clean_shutdown();
     void unclean_shutdown();
+    void handshake_progressed();
+    void segment_sent(const TCPHeader &header);
 
   public:
     //! \name "Input" interface for the writer
@@ -42,11 +72,25 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, adopting its storage if it is all accepted
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
+    //! \brief Write data to the outbound byte stream, sharing the Buffer's storage instead of copying it
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Send only full-sized segments until uncork(), so that small writes are coalesced (like TCP_CORK)
+    void cork() { _sender.cork(); }
+
+    //! \brief Send the data held back since cork()
+    void uncork();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -54,6 +98,7 @@ class TCPConnection {
 
     //! \brief The inbound byte stream received from the peer
     ByteStream &inbound_stream() { return _receiver.stream_out(); }
+    const ByteStream &inbound_stream() const { return _receiver.stream_out(); }
     //!@}
 
     //! \name Accessors used for testing
@@ -67,8 +112,19 @@ class TCPConnection {
     size_t time_since_last_segment_received() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
+    //! \brief the most recent "official" TCP state the connection has been in (tracked without string summaries)
+    TCPState::State fsm_state() const { return _state; }
+    //! \brief round-trip time statistics of the outbound stream
+    const RTTEstimator &rtt_stats() const { return _sender.rtt(); }
+    //! \brief the current retransmission timeout, in milliseconds
+    unsigned int retransmission_timeout() const { return _sender.retransmission_timeout(); }
+    //! \brief number of received segments handled by header prediction, without the general path
+    size_t predicted_segments() const { return _predicted_segments; }
     //!@}
 
+    //! \brief Milliseconds until tick() next has something to do, or nothing if no timer is running
+    std::optional<size_t> time_until_next_timeout() const;
+
     //! \name Methods for the owner or operating system to call
     //!@{
 
@@ -20,22 +20,28 @@ using namespace std;
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     auto datagram = _sock.recv();
+    return read(move(datagram.payload), &datagram.source_address);
+}
 
+//! \param[in] payload is the UDP payload
+//! \param[in] source is the address it came from
+//! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
+optional<TCPSegment> TCPOverUDPSocketAdapter::read(string &&payload, const Address *source) {
     // is it for us?
-    if (not listening() and (datagram.source_address != config().destination)) {
+    if (not source or (not listening() and (*source != config().destination))) {
         return {};
     }
 
     // is the payload a valid TCP segment?
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(payload), 0)) {
         return {};
     }
 
     // should we target this source in all future replies?
     if (listening()) {
         if (seg.header().syn and not seg.header().rst) {
-            config_mutable().destination = datagram.source_address;
+            config_mutable().destination = *source;
             set_listening(false);
         } else {
             return {};
@@ -48,9 +54,48 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    seg.header().sport = flow().local_port;
+    seg.header().dport = flow().remote_port;
+    _sock.sendto(config().destination, seg.serialize_packet(0));
+}
+
+//! \details With EventLoop::Backend::IOUring, the datagram is queued and sent with the next wait.
+//! \param[in] seg is the TCP segment to write
+//! \param[in] eventloop is the EventLoop that sends the datagram
+void TCPOverUDPSocketAdapter::write(TCPSegment &seg, EventLoop &eventloop) {
+    seg.header().sport = flow().local_port;
+    seg.header().dport = flow().remote_port;
+    eventloop.write_datagram(_sock, seg.serialize_packet(0), &config().destination);
+}
+
+//! \details Only `flow.local_address` comes from the configuration (the socket's own address); the rest comes
+//! from the datagram.
+//! \param[in] payload is the UDP payload
+//! \param[in] source is the address it came from
+//! \param[out] flow is set to the connection that the segment belongs to
+//! \returns a std::optional<TCPSegment> that is empty if the payload was not a valid TCP segment
+optional<TCPSegment> TCPOverUDPSocketAdapter::read(string &&payload, const Address *source, FlowKey &flow) {
+    if (not source) {
+        return {};
+    }
+
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(move(payload), 0)) {
+        return {};
+    }
+
+    flow = {this->flow().local_address, source->ipv4_numeric(), seg.header().dport, source->ipv4_port()};
+    return seg;
+}
+
+//! \param[in] seg is the TCP segment to write
+//! \param[in] flow is its connection, whose remote address and port are the peer's UDP address
+//! \param[in] eventloop is the EventLoop that sends the datagram
+void TCPOverUDPSocketAdapter::write(TCPSegment &seg, const FlowKey &flow, EventLoop &eventloop) {
+    seg.header().sport = flow.local_port;
+    seg.header().dport = flow.remote_port;
+    const Address destination = Address::from_ipv4_numeric(flow.remote_address, flow.remote_port);
+    eventloop.write_datagram(_sock, seg.serialize_packet(0), &destination);
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
@@ -1,6 +1,8 @@
 #ifndef SPONGE_LIBSPONGE_FD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_FD_ADAPTER_HH
 
+#include "address.hh"
+#include "eventloop.hh"
 #include "file_descriptor.hh"
 #include "lossy_fd_adapter.hh"
 #include "socket.hh"
@@ -9,6 +11,7 @@
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <string>
 #include <utility>
 
 //! \brief Basic functionality for file descriptor adaptors
@@ -18,8 +21,13 @@ class FdAdapterBase {
     FdAdapterConfig _cfg{};  //!< Configuration values
     bool _listen = false;    //!< Is the connected TCP FSM in listen state?
 
+    mutable std::optional<FlowKey> _flow{};  //!< `_cfg.flow()`, until the configuration is next handed out mutably
+
   protected:
-    FdAdapterConfig &config_mutable() { return _cfg; }
+    FdAdapterConfig &config_mutable() {
+        _flow.reset();
+        return _cfg;
+    }
 
   public:
     //! \brief Set the listening flag
@@ -35,8 +43,21 @@ class FdAdapterBase {
     const FdAdapterConfig &config() const { return _cfg; }
 
     //! \brief Get the current configuration (mutable)
-    //! \returns a mutable reference
-    FdAdapterConfig &config_mut() { return _cfg; }
+    //! \returns a mutable reference, which should not be kept: flow() is resolved again only after this call
+    FdAdapterConfig &config_mut() {
+        _flow.reset();
+        return _cfg;
+    }
+
+    //! \brief Get the current configuration's addresses and ports as numbers
+    //! \details Resolved once after each change, so that reading and writing segments never calls into the
+    //! resolver.
+    const FlowKey &flow() const {
+        if (not _flow.has_value()) {
+            _flow = _cfg.flow();
+        }
+        return _flow.value();
+    }
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
@@ -54,9 +75,26 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
+    //! Attempts to parse a UDP payload already read by an EventLoop datagram rule
+    std::optional<TCPSegment> read(std::string &&payload, const Address *source);
+
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Writes a TCP segment into a UDP payload, through EventLoop::write_datagram
+    void write(TCPSegment &seg, EventLoop &eventloop);
+
+    //! \name Connections sharing the socket (see TCPEndpoint)
+    //! A connection is identified by the peer's UDP address and the TCP port it sends to.
+    //!@{
+
+    //! Parses a TCP segment from a UDP payload, whatever connection it belongs to, and sets `flow` to that connection
+    std::optional<TCPSegment> read(std::string &&payload, const Address *source, FlowKey &flow);
+
+    //! Writes a TCP segment of the connection `flow` into a UDP payload, through EventLoop::write_datagram
+    void write(TCPSegment &seg, const FlowKey &flow, EventLoop &eventloop);
+    //!@}
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -27,15 +27,16 @@ BufferList IPv4Datagram::serialize() const {
 
     IPv4Header header_out = _header;
     header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    string header_str = header_out.serialize();
 
-    // calculate checksum -- taken over header only
+    // calculate checksum -- taken over header only -- and write it in place
     InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    check.add(header_str);
+    char *cksum_out = header_str.data() + IPv4Header::CKSUM_OFFSET;
+    NetUnparser::u16(cksum_out, check.value());
 
     BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(move(header_str));
     ret.append(_payload);
     return ret;
 }
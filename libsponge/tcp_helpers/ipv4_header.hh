@@ -9,6 +9,7 @@ struct IPv4Header {
     static constexpr size_t LENGTH = 20;         //!< [IPv4](\ref rfc::rfc791) header length, not including options
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
+    static constexpr size_t CKSUM_OFFSET = 10;   //!< Offset of the checksum field in the serialized header
 
     //! \struct IPv4Header
     //! ~~~{.txt}
@@ -52,6 +53,9 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! Serialize the IP fields in place, into the `4 * hlen` bytes at `out`
+    void serialize(char *out) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
@@ -1,6 +1,8 @@
 #ifndef SPONGE_LIBSPONGE_LOSSY_FD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_LOSSY_FD_ADAPTER_HH
 
+#include "address.hh"
+#include "eventloop.hh"
 #include "file_descriptor.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
@@ -8,6 +10,7 @@
 
 #include <optional>
 #include <random>
+#include <string>
 #include <utility>
 
 //! An adapter class that adds random dropping behavior to an FD adapter
@@ -47,6 +50,15 @@ class LossyFdAdapter {
         return ret;
     }
 
+    //! \brief Parse a datagram read by an EventLoop datagram rule, potentially dropping it
+    std::optional<TCPSegment> read(std::string &&datagram, const Address *source) {
+        auto ret = _adapter.read(std::move(datagram), source);
+        if (_should_drop(false)) {
+            return {};
+        }
+        return ret;
+    }
+
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
     void write(TCPSegment &seg) {
@@ -56,6 +68,31 @@ class LossyFdAdapter {
         return _adapter.write(seg);
     }
 
+    //! \brief Write through EventLoop::write_datagram, potentially dropping the datagram to be written
+    void write(TCPSegment &seg, EventLoop &eventloop) {
+        if (_should_drop(true)) {
+            return;
+        }
+        return _adapter.write(seg, eventloop);
+    }
+
+    //! \brief Parse a datagram of any connection (see TCPEndpoint), potentially dropping it
+    std::optional<TCPSegment> read(std::string &&datagram, const Address *source, FlowKey &flow) {
+        auto ret = _adapter.read(std::move(datagram), source, flow);
+        if (_should_drop(false)) {
+            return {};
+        }
+        return ret;
+    }
+
+    //! \brief Write a segment of the connection `flow`, potentially dropping it
+    void write(TCPSegment &seg, const FlowKey &flow, EventLoop &eventloop) {
+        if (_should_drop(true)) {
+            return;
+        }
+        return _adapter.write(seg, flow, eventloop);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -2,10 +2,15 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <netinet/in.h>
 #include <optional>
 
 //! Config for TCP sender and receiver
@@ -15,11 +20,72 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;    //!< Largest window scale shift allowed by RFC 7323
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;   //!< Duplicate ACKs that signal a lost segment (RFC 5681)
+    static constexpr uint16_t MIN_RTO_DFLT = 200;      //!< Default lower bound of the adaptive RTO, as in Linux
+    static constexpr unsigned MAX_RTO_DFLT = 60000;    //!< Default upper bound of the adaptive RTO (RFC 6298)
+    static constexpr unsigned ACK_EVERY_DFLT = 2;      //!< Default segments per delayed ACK (RFC 5681 asks for 2)
+    static constexpr uint16_t ACK_DELAY_DFLT = 40;     //!< Default delayed-ACK timeout, as in Linux (RFC 5681: < 500)
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                //!< Derive the RTO from measured RTTs instead of resetting it on ACK
+    uint16_t min_rto = MIN_RTO_DFLT;          //!< Lower bound of the adaptive RTO, in milliseconds
+    unsigned max_rto = MAX_RTO_DFLT;          //!< Upper bound of the adaptive RTO (and its backoff), in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    size_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to receive (offered on SYN) or to send, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    ByteStream::Backend stream_backend = ByteStream::Backend::BufferList;  //!< Storage for the inbound/outbound streams
+    StreamReassembler::Engine reassembler_engine = StreamReassembler::Engine::SortedMap;  //!< Storage for reordered data
+    bool window_scaling = false;  //!< Offer the RFC 7323 window scale option, so windows can exceed 64 KiB
+    bool sack = false;            //!< Offer RFC 2018 selective acknowledgments, so fast recovery can find the holes
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;  //!< Congestion control
+    bool fast_retransmit = false;  //!< Retransmit the first outstanding segment after DUP_ACK_THRESHOLD duplicate ACKs
+    bool nagle = false;            //!< Hold back short segments while data is unacknowledged (RFC 896)
+    bool delayed_ack = false;      //!< ACK in-order data only every `ack_every` segments or after `ack_delay` ms
+    unsigned ack_every = ACK_EVERY_DFLT;  //!< Data segments received before a delayed ACK is sent regardless
+    uint16_t ack_delay = ACK_DELAY_DFLT;  //!< Longest time a delayed ACK is held back, in milliseconds
+
+    //! \returns the smallest window scale shift that lets the 16-bit window field cover `recv_capacity`
+    uint8_t recv_window_scale() const {
+        uint8_t shift = 0;
+        while (shift < MAX_WINDOW_SCALE and (recv_capacity >> shift) > UINT16_MAX) {
+            shift++;
+        }
+        return shift;
+    }
+};
+
+//! \brief The addresses and ports of a TCP connection, seen from our side
+//! \details Identifies a connection among the many that share one adapter (see TCPEndpoint).
+//! Addresses are IPv4 and, like the ports, in host byte order.
+struct FlowKey {
+    uint32_t local_address{0};
+    uint32_t remote_address{0};
+    uint16_t local_port{0};
+    uint16_t remote_port{0};
+
+    //! Both addresses and the protocol of the IPv4 pseudo-header, summed for the TCP checksum (the same in either
+    //! direction); adding the TCP length gives IPv4Header::pseudo_cksum()
+    uint32_t pseudo_sum{0};
+
+    FlowKey() = default;
+
+    //! Construct from the addresses and ports, and sum the pseudo-header once
+    FlowKey(const uint32_t local_addr, const uint32_t remote_addr, const uint16_t local_p, const uint16_t remote_p)
+        : local_address(local_addr)
+        , remote_address(remote_addr)
+        , local_port(local_p)
+        , remote_port(remote_p)
+        , pseudo_sum((local_addr >> 16) + (local_addr & 0xffff) + (remote_addr >> 16) + (remote_addr & 0xffff) +
+                     IPPROTO_TCP) {}
+
+    //! Compares the addresses and ports (`pseudo_sum` follows from them)
+    bool operator==(const FlowKey &other) const {
+        return local_address == other.local_address and remote_address == other.remote_address and
+               local_port == other.local_port and remote_port == other.remote_port;
+    }
+    bool operator!=(const FlowKey &other) const { return not operator==(other); }
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +96,28 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    //! \brief The IPv4 addresses and ports as numbers, with `source` as the local end
+    //! \note Goes through the resolver ([getnameinfo(3)](\ref man3::getnameinfo)) for the ports, so adapters
+    //! keep the result (see FdAdapterBase::flow)
+    FlowKey flow() const {
+        return {source.ipv4_numeric(), destination.ipv4_numeric(), source.port(), destination.port()};
+    }
+};
+
+namespace std {
+//! Hash of a FlowKey, for std::unordered_map
+template <>
+struct hash<FlowKey> {
+    size_t operator()(const FlowKey &flow) const noexcept {
+        // multiply to mix, so that every bit of the key reaches the low bits that pick the bucket
+        const uint64_t remote = (uint64_t(flow.remote_address) << 32) | (uint32_t(flow.remote_port) << 16) |
+                                flow.local_port;
+        uint64_t h = remote * 0x9e3779b97f4a7c15ULL ^ flow.local_address;
+        h ^= h >> 29;
+        return h;
+    }
 };
+}  // namespace std
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -0,0 +1,232 @@
+#include "tcp_endpoint.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] adapter is the adapter whose file descriptor all connections share
+//! \param[in] c_tcp is the TCPConfig for every TCPConnection
+//! \param[in] c_ad is the FdAdapterConfig for the adapter (its `destination` is not used)
+template <typename AdaptT>
+TCPEndpoint<AdaptT>::TCPEndpoint(AdaptT &&adapter, const TCPConfig &c_tcp, const FdAdapterConfig &c_ad)
+    : _adapter(move(adapter))
+    , _config(c_tcp)
+    , _local_address(c_ad.source.ipv4_numeric())
+    , _local_port(c_ad.source.port())
+    , _timers(timestamp_ms()) {
+    _adapter.config_mut() = c_ad;
+
+    // 所有连接的数据报都从同一个 fd 读入，按 FlowKey 分发
+    _eventloop.add_datagram_rule(_adapter, [&](string &&datagram, const Address *source) {
+        FlowKey flow{};
+        auto seg = _adapter.read(move(datagram), source, flow);
+        if (seg.has_value()) {
+            segment_received(flow, move(seg.value()));
+        }
+    });
+}
+
+//! \param[in] backlog is the most connections that may wait for accept(), counting those still in their handshake
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::listen(const size_t backlog) {
+    _listening = true;
+    _backlog = backlog;
+}
+
+//! \param[in] destination is the peer's address and port (over UDP, its UDP socket)
+//! \param[in] local_port is the local port of the connection; 0 for the adapter's
+template <typename AdaptT>
+FlowKey TCPEndpoint<AdaptT>::connect(const Address &destination, const uint16_t local_port) {
+    const FlowKey flow{
+        _local_address, destination.ipv4_numeric(), local_port ? local_port : _local_port, destination.port()};
+    if (_connections.count(flow)) {
+        throw runtime_error("TCPEndpoint: connection to " + destination.to_string() + " already exists");
+    }
+
+    const auto it = _connections.try_emplace(flow, _config, timestamp_ms(), false).first;
+    it->second.tcp.connect();
+    flush(it);
+    return flow;
+}
+
+//! \details Also makes room in the backlog for another connection.
+template <typename AdaptT>
+optional<FlowKey> TCPEndpoint<AdaptT>::accept() {
+    if (_accept_queue.empty()) {
+        return {};
+    }
+    const FlowKey flow = _accept_queue.front();
+    _accept_queue.pop_front();
+    _unaccepted--;
+    _connections.at(flow).accepted = true;
+    return flow;
+}
+
+template <typename AdaptT>
+size_t TCPEndpoint<AdaptT>::write(const FlowKey &flow, string &&data) {
+    const auto it = find(flow);
+    tick(it->second);
+    const size_t written = it->second.tcp.write(move(data));
+    flush(it);
+    return written;
+}
+
+template <typename AdaptT>
+string TCPEndpoint<AdaptT>::read(const FlowKey &flow, const size_t max_len) {
+    ByteStream &inbound = find(flow)->second.tcp.inbound_stream();
+    return inbound.read(min(max_len, inbound.buffer_size()));
+}
+
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::end_input_stream(const FlowKey &flow) {
+    const auto it = find(flow);
+    tick(it->second);
+    it->second.tcp.end_input_stream();
+    flush(it);
+}
+
+//! \param[in] timeout_ms is the longest wait in milliseconds, or -1 to wait until a datagram or timer is due
+template <typename AdaptT>
+EventLoop::Result TCPEndpoint<AdaptT>::wait_next_event(const int timeout_ms) {
+    // 最早的定时器到期时醒来
+    const auto now = timestamp_ms();
+    int wait_ms = timeout_ms;
+    const auto next_expiry = _timers.next_expiry();
+    if (next_expiry.has_value()) {
+        const auto until_expiry = static_cast<int>(min<uint64_t>(
+            next_expiry.value() > now ? next_expiry.value() - now : 0, numeric_limits<int>::max()));
+        wait_ms = timeout_ms < 0 ? until_expiry : min(timeout_ms, until_expiry);
+    }
+
+    const auto result = _eventloop.wait_next_event(wait_ms);
+    const auto after = timestamp_ms();
+    _adapter.tick(after - now);
+    _timers.advance(after);
+    return result;
+}
+
+template <typename AdaptT>
+typename TCPEndpoint<AdaptT>::ConnectionIter TCPEndpoint<AdaptT>::find(const FlowKey &flow) {
+    const auto it = _connections.find(flow);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPEndpoint: no such connection");
+    }
+    return it;
+}
+
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::segment_received(const FlowKey &flow, TCPSegment &&seg) {
+    if (_local_address != 0 and flow.local_address != _local_address) {
+        return;  // TUN 设备上发给别的地址的数据报
+    }
+
+    auto it = _connections.find(flow);
+    if (it == _connections.end()) {
+        // 未知的 flow：只有发往监听端口的 SYN 才能打开新连接
+        const TCPHeader &header = seg.header();
+        const bool opens = header.syn and not header.ack and not header.rst;
+        if (not _listening or not opens or flow.local_port != _local_port or _unaccepted >= _backlog) {
+            return;
+        }
+        it = _connections.try_emplace(flow, _config, timestamp_ms(), true).first;
+        _unaccepted++;
+    }
+
+    tick(it->second);
+    it->second.tcp.segment_received(seg);
+    handle(flow, it);
+}
+
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::timer_expired(const FlowKey &flow) {
+    const auto it = _connections.find(flow);
+    if (it == _connections.end()) {
+        return;
+    }
+    it->second.timer.reset();
+    tick(it->second);
+    handle(flow, it);
+}
+
+//! \details The handler may open connections (invalidating `it`) or finish this one, so it is looked up again.
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::handle(const FlowKey flow, ConnectionIter it) {
+    if (it->second.accepted and _handler) {
+        _handler(flow);
+        it = _connections.find(flow);
+        if (it == _connections.end()) {
+            return;
+        }
+    }
+    flush(it);
+}
+
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::tick(Connection &connection) {
+    const auto now = timestamp_ms();
+    if (connection.tcp.active()) {
+        connection.tcp.tick(now - connection.last_tick_time);
+    }
+    connection.last_tick_time = now;
+}
+
+//! \details Sends the connection's segments, moves it to the accept queue when its handshake completes,
+//! and then either replaces its timer or, if it is no longer active, forgets it.
+template <typename AdaptT>
+void TCPEndpoint<AdaptT>::flush(const ConnectionIter it) {
+    const FlowKey &flow = it->first;
+    Connection &connection = it->second;
+    auto &segments = connection.tcp.segments_out();
+    while (not segments.empty()) {
+        _adapter.write(segments.front(), flow, _eventloop);
+        segments.pop();
+    }
+
+    if (connection.timer.has_value()) {
+        _timers.cancel(connection.timer.value());
+        connection.timer.reset();
+    }
+
+    if (not connection.tcp.active()) {
+        if (connection.passive and not connection.accepted) {
+            _unaccepted--;
+            if (connection.queued) {
+                _accept_queue.erase(find_if(
+                    _accept_queue.begin(), _accept_queue.end(), [&](const FlowKey &queued) { return queued == flow; }));
+            }
+        }
+        _connections.erase(it);
+        return;
+    }
+
+    const auto state = connection.tcp.fsm_state();
+    if (connection.passive and not connection.queued and state != TCPState::State::LISTEN and
+        state != TCPState::State::SYN_RCVD) {
+        connection.queued = true;
+        _accept_queue.push_back(flow);
+    }
+
+    const auto timeout = connection.tcp.time_until_next_timeout();
+    if (timeout.has_value()) {
+        const FlowKey key = flow;
+        connection.timer =
+            _timers.add(connection.last_tick_time + timeout.value(), [this, key] { timer_expired(key); });
+    }
+}
+
+//! Specialization of TCPEndpoint for TCPOverUDPSocketAdapter
+template class TCPEndpoint<TCPOverUDPSocketAdapter>;
+
+//! Specialization of TCPEndpoint for TCPOverIPv4OverTunFdAdapter
+template class TCPEndpoint<TCPOverIPv4OverTunFdAdapter>;
+
+//! Specialization of TCPEndpoint for LossyTCPOverUDPSocketAdapter
+template class TCPEndpoint<LossyTCPOverUDPSocketAdapter>;
+
+//! Specialization of TCPEndpoint for LossyTCPOverIPv4OverTunFdAdapter
+template class TCPEndpoint<LossyTCPOverIPv4OverTunFdAdapter>;
@@ -0,0 +1,157 @@
+#ifndef SPONGE_LIBSPONGE_TCP_ENDPOINT_HH
+#define SPONGE_LIBSPONGE_TCP_ENDPOINT_HH
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "timer_wheel.hh"
+#include "tuntap_adapter.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+//! \brief Many TCPConnections sharing one adapter, driven by one EventLoop in the caller's thread
+template <typename AdaptT>
+class TCPEndpoint {
+  public:
+    //! Called after a segment or a timer has been handled for an accepted or connected connection
+    using HandlerT = std::function<void(const FlowKey &flow)>;
+
+  private:
+    //! \brief A connection and the bookkeeping around it
+    struct Connection {
+        TCPConnection tcp;
+        uint64_t last_tick_time;                     //!< when `tcp` was last told the time, in milliseconds
+        std::optional<TimerWheel::TimerId> timer{};  //!< ticks `tcp` at its next timeout
+        bool passive;                                //!< created by a SYN to the listening port
+        bool queued{false};                          //!< passive, and put in the accept queue
+        bool accepted;                               //!< returned by connect() or accept()
+
+        Connection(const TCPConfig &config, const uint64_t now, const bool is_passive)
+            : tcp(config), last_tick_time(now), passive(is_passive), accepted(not is_passive) {}
+    };
+
+    using ConnectionIter = typename std::unordered_map<FlowKey, Connection>::iterator;
+
+    AdaptT _adapter;
+    TCPConfig _config;
+    uint32_t _local_address;  //!< from the adapter's FdAdapterConfig::source; 0 accepts any
+    uint16_t _local_port;     //!< likewise; the listening port
+
+    //! \name Listening
+    //!@{
+    bool _listening{false};
+    size_t _backlog{0};                   //!< most passive connections not yet returned by accept()
+    size_t _unaccepted{0};                //!< passive connections not yet returned by accept(), handshake or not
+    std::deque<FlowKey> _accept_queue{};  //!< established passive connections, oldest first
+    //!@}
+
+    std::unordered_map<FlowKey, Connection> _connections{};
+    TimerWheel _timers;
+    HandlerT _handler{};
+    EventLoop _eventloop{EventLoop::Backend::IOUring};
+
+    ConnectionIter find(const FlowKey &flow);
+    void segment_received(const FlowKey &flow, TCPSegment &&seg);
+    void timer_expired(const FlowKey &flow);
+    void tick(Connection &connection);
+    void handle(const FlowKey flow, ConnectionIter it);
+    void flush(const ConnectionIter it);
+
+  public:
+    //! Construct from the adapter that all connections will share; `c_ad.source` is the local address and port
+    TCPEndpoint(AdaptT &&adapter, const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
+
+    //! \brief Accept connections to the local port, with at most `backlog` of them waiting for accept()
+    void listen(const size_t backlog);
+
+    //! \brief Open a connection to `destination`, from `local_port` (by default the local port of the adapter)
+    //! \returns the connection's FlowKey, valid until its handler call sees it inactive
+    FlowKey connect(const Address &destination, const uint16_t local_port = 0);
+
+    //! \brief Take the oldest connection that has completed its handshake, if any
+    std::optional<FlowKey> accept();
+
+    //! \brief Call `handler` after every event on an accepted or connected connection
+    //! \details The handler may read, write and end the connection's streams. After it returns, a connection
+    //! that is no longer active is forgotten.
+    void set_handler(const HandlerT &handler) { _handler = handler; }
+
+    //! \name Operations on a connection
+    //!@{
+
+    //! \brief Write to the outbound stream of `flow`, and send what the window allows
+    //! \returns the number of bytes accepted
+    size_t write(const FlowKey &flow, std::string &&data);
+
+    //! \brief Read up to `max_len` bytes that `flow` has received
+    std::string read(const FlowKey &flow, const size_t max_len);
+
+    //! \brief Shut down the outbound stream of `flow`
+    void end_input_stream(const FlowKey &flow);
+
+    //! \returns the TCPConnection of `flow` (to be inspected; use the operations above to change it)
+    const TCPConnection &connection(const FlowKey &flow) const { return _connections.at(flow).tcp; }
+
+    //! \returns whether `flow` is a connection of this endpoint
+    bool contains(const FlowKey &flow) const { return _connections.count(flow) > 0; }
+    //!@}
+
+    //! \returns the number of connections, including those in a handshake or lingering
+    size_t size() const { return _connections.size(); }
+
+    //! \brief Handle the datagrams and timers that are due, waiting up to `timeout_ms` for the first one
+    //! \returns EventLoop::Result::Timeout if no datagram arrived (timers may still have expired)
+    EventLoop::Result wait_next_event(const int timeout_ms);
+
+    //! \name
+    //! The event loop, timers and handler refer to the endpoint, so it cannot be copied or moved
+
+    //!@{
+    TCPEndpoint(const TCPEndpoint &) = delete;
+    TCPEndpoint(TCPEndpoint &&) = delete;
+    TCPEndpoint &operator=(const TCPEndpoint &) = delete;
+    TCPEndpoint &operator=(TCPEndpoint &&) = delete;
+    //!@}
+};
+
+using TCPOverUDPEndpoint = TCPEndpoint<TCPOverUDPSocketAdapter>;
+using TCPOverIPv4Endpoint = TCPEndpoint<TCPOverIPv4OverTunFdAdapter>;
+using LossyTCPOverUDPEndpoint = TCPEndpoint<LossyTCPOverUDPSocketAdapter>;
+using LossyTCPOverIPv4Endpoint = TCPEndpoint<LossyTCPOverIPv4OverTunFdAdapter>;
+
+//! \class TCPEndpoint
+//! Where TCPSpongeSocket runs one TCPConnection in a thread of its own, with its own adapter, a TCPEndpoint
+//! serves any number of connections from the thread that calls wait_next_event(). The adapter's file
+//! descriptor (a UDP socket or a TUN device) is shared: each segment read from it is routed by its FlowKey to
+//! its connection in a hash table. A SYN for an unknown flow to the local port opens a new connection if the
+//! endpoint is listening and its backlog has room; other segments for unknown flows are dropped. The
+//! connections' timeouts share one TimerWheel, and their segments go out through EventLoop::write_datagram,
+//! so with the io_uring backend a wait that serves many connections still costs one system call.
+//!
+//! A typical server:
+//!
+//! ~~~{.cpp}
+//! TCPOverUDPEndpoint endpoint{TCPOverUDPSocketAdapter{move(socket)}, tcp_config, adapter_config};
+//! endpoint.set_handler([&](const FlowKey &flow) { /* read(flow, ...), write(flow, ...) */ });
+//! endpoint.listen(128);
+//! while (true) {
+//!     endpoint.wait_next_event(-1);
+//!     while (const auto flow = endpoint.accept()) {
+//!         // a new connection
+//!     }
+//! }
+//! ~~~
+//!
+//! Over UDP, the peer's UDP address stands for its IP address and port, so there is one connection per peer
+//! socket and local port.
+
+#endif  // SPONGE_LIBSPONGE_TCP_ENDPOINT_HH
@@ -1,5 +1,6 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -37,8 +38,43 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse the options we know about, and skip any others or anything extra in the header
+    mss.reset();
+    wscale.reset();
+    sack_permitted = false;
+    sack.clear();
+    size_t options_length = doff * 4 - TCPHeader::LENGTH;
+    while (options_length > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        options_length--;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+
+        const uint8_t length = options_length > 0 ? p.u8() : 0;
+        if (length < 2 or length - 1U > options_length) {
+            return ParseResult::HeaderTooShort;
+        }
+        options_length -= length - 1U;
+        if (kind == OPT_MSS and length == 4) {
+            mss = p.u16();
+        } else if (kind == OPT_WSCALE and length == 3) {
+            wscale = p.u8();
+        } else if (kind == OPT_SACK_PERMITTED and length == 2) {
+            sack_permitted = true;
+        } else if (kind == OPT_SACK and length % 8 == 2) {
+            for (size_t i = 0; i < length / 8U; i++) {
+                const WrappingInt32 left{p.u32()};
+                sack.push_back({left, WrappingInt32{p.u32()}});
+            }
+        } else {
+            p.remove_prefix(length - 2);
+        }
+    }
+    p.remove_prefix(options_length);
 
     if (p.error()) {
         return p.get_error();
@@ -47,34 +83,83 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+//! \returns the length of the serialized header: `4 * doff`, raised if needed to make room for the options
+size_t TCPHeader::length() const {
+    size_t options = 0;
+    options += mss.has_value() ? 4 : 0;
+    options += wscale.has_value() ? 4 : 0;  // padded to a 4-byte boundary
+    options += sack_permitted ? 4 : 0;
+    if (not sack.empty()) {
+        if (sack.size() > MAX_SACK_BLOCKS) {
+            throw runtime_error("too many SACK blocks");
+        }
+        options += 4 + 8 * sack.size();
+    }
+    return max<size_t>(4 * doff, TCPHeader::LENGTH + options);
+}
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
+    string ret(length(), 0);
+    serialize(ret.data());
+    return ret;
+}
+
+//! \param[out] out is where to write the header; it must have room for length() bytes
+//! \details Does not recompute the checksum.
+void TCPHeader::serialize(char *out) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
+    const size_t len = length();
+    char *const end = out + len;
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u16(out, sport);              // source port
+    NetUnparser::u16(out, dport);              // destination port
+    NetUnparser::u32(out, seqno.raw_value());  // sequence number
+    NetUnparser::u32(out, ackno.raw_value());  // ack number
+    NetUnparser::u8(out, (len / 4) << 4);      // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    NetUnparser::u8(out, fl_b);  // flags
+    NetUnparser::u16(out, win);  // window size
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    NetUnparser::u16(out, cksum);  // checksum
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    NetUnparser::u16(out, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    if (mss.has_value()) {
+        NetUnparser::u8(out, OPT_MSS);
+        NetUnparser::u8(out, 4);
+        NetUnparser::u16(out, mss.value());
+    }
+    if (wscale.has_value()) {
+        NetUnparser::u8(out, OPT_NOP);  // pad to a 4-byte boundary
+        NetUnparser::u8(out, OPT_WSCALE);
+        NetUnparser::u8(out, 3);
+        NetUnparser::u8(out, wscale.value());
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(out, OPT_NOP);
+        NetUnparser::u8(out, OPT_NOP);
+        NetUnparser::u8(out, OPT_SACK_PERMITTED);
+        NetUnparser::u8(out, 2);
+    }
+    if (not sack.empty()) {
+        NetUnparser::u8(out, OPT_NOP);
+        NetUnparser::u8(out, OPT_NOP);
+        NetUnparser::u8(out, OPT_SACK);
+        NetUnparser::u8(out, 2 + 8 * sack.size());
+        for (const auto &block : sack) {
+            NetUnparser::u32(out, block.left.raw_value());
+            NetUnparser::u32(out, block.right.raw_value());
+        }
+    }
 
-    return ret;
+    fill(out, end, 0);  // expand header to advertised size
 }
 
 //! \returns A string with the header's contents
@@ -90,13 +175,38 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP mss: " << +mss.value() << '\n';
+    }
+    if (wscale.has_value()) {
+        ss << "TCP wscale: " << +wscale.value() << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (const auto &block : sack) {
+        ss << "TCP SACK: " << block.left << "-" << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (wscale.has_value()) {
+        ss << ",wscale=" << +wscale.value();
+    }
+    if (sack_permitted) {
+        ss << ",sackOK";
+    }
+    for (const auto &block : sack) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +214,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && wscale == other.wscale && sack_permitted == other.sack_permitted &&
+           sack == other.sack;
 }
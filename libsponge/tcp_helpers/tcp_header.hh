@@ -4,10 +4,33 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The TCP options supported are maximum segment size, window scale ([RFC 7323](\ref rfc::rfc7323))
+//! and selective acknowledgments ([RFC 2018](\ref rfc::rfc2018)); others are skipped
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;        //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t CKSUM_OFFSET = 16;  //!< Offset of the checksum field in the serialized header
+
+    //! \name TCP option kinds
+    //!@{
+    static constexpr uint8_t OPT_EOL = 0;             //!< end of option list
+    static constexpr uint8_t OPT_NOP = 1;             //!< no-operation (padding)
+    static constexpr uint8_t OPT_MSS = 2;             //!< maximum segment size, only valid on SYN segments
+    static constexpr uint8_t OPT_WSCALE = 3;          //!< window scale, only valid on SYN segments
+    static constexpr uint8_t OPT_SACK_PERMITTED = 4;  //!< SACK permitted, only valid on SYN segments
+    static constexpr uint8_t OPT_SACK = 5;            //!< SACK blocks
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< as many blocks as fit in the 40 bytes of options
+    //!@}
+
+    //! A block of data the receiver holds beyond the ackno: `left` is its first seqno, `right` is one past its last
+    struct SackBlock {
+        WrappingInt32 left;
+        WrappingInt32 right;
+        bool operator==(const SackBlock &other) const { return left == other.left && right == other.right; }
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +73,27 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};    //!< largest payload the segment's sender accepts (only sent on SYN segments)
+    std::optional<uint8_t> wscale{};  //!< window scale shift count (only sent on SYN segments)
+    bool sack_permitted = false;      //!< the sender of the SYN can receive SACK blocks
+    std::vector<SackBlock> sack{};    //!< SACK blocks, at most MAX_SACK_BLOCKS
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
+    //! \note `doff` is raised if needed to make room for the options
     std::string serialize() const;
 
+    //! Serialize the TCP fields in place, into the length() bytes at `out`
+    void serialize(char *out) const;
+
+    //! Length of the serialized header, in bytes
+    size_t length() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
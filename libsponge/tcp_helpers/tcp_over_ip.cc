@@ -3,8 +3,8 @@
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
+#include "util.hh"
 
-#include <arpa/inet.h>
 #include <stdexcept>
 #include <unistd.h>
 #include <utility>
@@ -26,12 +26,12 @@ using namespace std;
 optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram) {
     // is the IPv4 datagram for us?
     // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
-    if (not listening() and (ip_dgram.header().dst != config().source.ipv4_numeric())) {
+    if (not listening() and (ip_dgram.header().dst != flow().local_address)) {
         return {};
     }
 
     // is the IPv4 datagram from our peer?
-    if (not listening() and (ip_dgram.header().src != config().destination.ipv4_numeric())) {
+    if (not listening() and (ip_dgram.header().src != flow().remote_address)) {
         return {};
     }
 
@@ -47,15 +47,16 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     }
 
     // is the TCP segment for us?
-    if (tcp_seg.header().dport != config().source.port()) {
+    if (tcp_seg.header().dport != flow().local_port) {
         return {};
     }
 
     // should we target this source addr/port (and use its destination addr as our source) in reply?
     if (listening()) {
         if (tcp_seg.header().syn and not tcp_seg.header().rst) {
-            config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
-            config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
+            const uint16_t local_port = flow().local_port;
+            config_mutable().source = Address::from_ipv4_numeric(ip_dgram.header().dst, local_port);
+            config_mutable().destination = Address::from_ipv4_numeric(ip_dgram.header().src, tcp_seg.header().sport);
             set_listening(false);
         } else {
             return {};
@@ -63,28 +64,74 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     }
 
     // is the TCP segment from our peer?
-    if (tcp_seg.header().sport != config().destination.port()) {
+    if (tcp_seg.header().sport != flow().remote_port) {
         return {};
     }
 
     return tcp_seg;
 }
 
+//! \param[in] ip_dgram is the IPv4 datagram to unwrap
+//! \param[out] flow is set to the connection that the segment belongs to
+//! \returns a std::optional<TCPSegment> that is empty if the payload was not a valid TCP segment
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, FlowKey &flow) {
+    // does the IPv4 datagram claim that its payload is a TCP segment?
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    // is the payload a valid TCP segment?
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    flow = {ip_dgram.header().dst, ip_dgram.header().src, tcp_seg.header().dport, tcp_seg.header().sport};
+    return tcp_seg;
+}
+
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
-    // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) { return wrap_tcp_in_ip(seg, flow()); }
 
-    // create an Internet Datagram and set its addresses and length
-    InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+//! \param[in] seg is the TCP segment to convert
+//! \param[in] flow is its connection
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg, const FlowKey &flow) {
+    seg.header().sport = flow.local_port;
+    seg.header().dport = flow.remote_port;
 
-    // set payload, calculating TCP checksum using information from IP header
-    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+    InternetDatagram ip_dgram;
+    ip_dgram.header().src = flow.local_address;
+    ip_dgram.header().dst = flow.remote_address;
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().length() + seg.payload().size();
+    // the addresses and protocol of the pseudo-header are already summed in the flow; add the length
+    ip_dgram.payload() = seg.serialize(flow.pseudo_sum + ip_dgram.header().payload_length());
 
     return ip_dgram;
 }
+
+//! \param[in] seg is the TCP segment to convert
+//! \param[in] flow is its connection
+//! \returns the datagram, with the IPv4 and TCP headers written into the headroom in front of the payload
+PacketBuffer TCPOverIPv4Adapter::wrap_tcp_in_packet(TCPSegment &seg, const FlowKey &flow) {
+    seg.header().sport = flow.local_port;
+    seg.header().dport = flow.remote_port;
+
+    const size_t tcp_length = seg.header().length() + seg.payload().size();
+    PacketBuffer packet = seg.serialize_packet(flow.pseudo_sum + tcp_length);
+
+    IPv4Header ip_header;
+    ip_header.src = flow.local_address;
+    ip_header.dst = flow.remote_address;
+    ip_header.len = ip_header.hlen * 4 + tcp_length;
+
+    // serialize the header with a zero checksum, then checksum it and write the checksum in place
+    char *const header_out = packet.prepend(ip_header.hlen * 4);
+    ip_header.serialize(header_out);
+    InternetChecksum check;
+    check.add({header_out, ip_header.hlen * 4u});
+    char *cksum_out = header_out + IPv4Header::CKSUM_OFFSET;
+    NetUnparser::u16(cksum_out, check.value());
+
+    return packet;
+}
@@ -4,6 +4,7 @@
 #include "buffer.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
+#include "tcp_config.hh"
 #include "tcp_segment.hh"
 
 #include <optional>
@@ -14,6 +15,19 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \name Connections sharing the adapter (see TCPEndpoint)
+    //!@{
+
+    //! Unwraps a TCP segment whatever connection it belongs to, and sets `flow` to that connection
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram, FlowKey &flow);
+
+    //! Wraps a TCP segment of the connection `flow` in an IPv4 datagram
+    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg, const FlowKey &flow);
+
+    //! Wraps a TCP segment of the connection `flow` in an IPv4 datagram, serialized with both headers in place
+    PacketBuffer wrap_tcp_in_packet(TCPSegment &seg, const FlowKey &flow);
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
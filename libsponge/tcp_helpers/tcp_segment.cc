@@ -19,27 +19,44 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
+    _payload_sum.reset();
     return p.get_error();
 }
 
+uint16_t TCPSegment::payload_sum() const {
+    if (not _payload_sum.has_value()) {
+        InternetChecksum check;
+        check.add(_payload);
+        _payload_sum = check.sum();
+    }
+    return _payload_sum.value();
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
-
-    // calculate checksum -- taken over entire segment
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
-
-    BufferList ret;
-    ret.append(header_out.serialize());
+    BufferList ret{string(serialize_packet(datagram_layer_checksum).headers())};
     ret.append(_payload);
-
     return ret;
 }
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+PacketBuffer TCPSegment::serialize_packet(const uint32_t datagram_layer_checksum) const {
+    // 首部直接写在 payload 前面的 headroom 里：计算时校验和字段按 0 算，算完后原地写入
+    PacketBuffer packet{_payload};
+    const size_t header_length = _header.length();
+    char *const header_out = packet.prepend(header_length);
+    _header.serialize(header_out);
+    header_out[TCPHeader::CKSUM_OFFSET] = header_out[TCPHeader::CKSUM_OFFSET + 1] = 0;
+
+    // 校验和覆盖整个 segment；首部长度是 4 的倍数，所以 payload 的和可以整体加上（重传时不必再算）
+    InternetChecksum check(datagram_layer_checksum + payload_sum());
+    check.add({header_out, header_length});
+    char *cksum_out = header_out + TCPHeader::CKSUM_OFFSET;
+    NetUnparser::u16(cksum_out, check.value());
+
+    return packet;
+}
@@ -5,12 +5,14 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <optional>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    mutable std::optional<uint16_t> _payload_sum{};  //!< payload_sum(), once computed
 
   public:
     //! \brief Parse the segment from a string
@@ -19,15 +21,34 @@ class TCPSegment {
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment into a PacketBuffer, writing the header in place in front of the payload
+    //! \details Lower layers can then prepend their own headers without copying (see PacketBuffer).
+    PacketBuffer serialize_packet(const uint32_t datagram_layer_checksum = 0) const;
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
     TCPHeader &header() { return _header; }
 
     const Buffer &payload() const { return _payload; }
-    Buffer &payload() { return _payload; }
+    //! \note Forgets the payload_sum(), since the payload may be changed through the reference
+    Buffer &payload() {
+        _payload_sum.reset();
+        return _payload;
+    }
     //!@}
 
+    //! \brief The one's complement sum of the payload (see InternetChecksum::sum)
+    //! \details Computed on first use and kept, so that serializing the segment again (or a copy of it) only
+    //! has to sum the header.
+    uint16_t payload_sum() const;
+
+    //! \brief Replace the payload with one whose payload_sum() is already known
+    void set_payload(const Buffer &payload, const uint16_t sum) {
+        _payload = payload;
+        _payload_sum = sum;
+    }
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -7,8 +7,10 @@
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -17,24 +19,69 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
-
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Instead of waking every few milliseconds to tick the TCPConnection, the loop sleeps until the
+//! earliest timer is due (or an event arrives), so an idle connection costs nothing. Without a timer it sleeps
+//! until an event: the owner's cork(), uncork() and abort signal `_wakeup`.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        const auto now = timestamp_ms();
+        const auto next_expiry = _timers.next_expiry();
+        int timeout_ms = -1;
+        if (next_expiry.has_value()) {
+            const uint64_t sleep_ms = next_expiry.value() > now ? next_expiry.value() - now : 0;
+            timeout_ms = static_cast<int>(min<uint64_t>(sleep_ms, numeric_limits<int>::max()));
+        }
+        auto ret = _eventloop.wait_next_event(timeout_ms);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
-        if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
-        }
+        _timers.advance(timestamp_ms());
+        _schedule_tcp_timer();
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_tick_tcp() {
+    const auto now = timestamp_ms();
+    if (_tcp.value().active()) {
+        _tcp.value().tick(now - _last_tick_time);
+        _datagram_adapter.tick(now - _last_tick_time);
+    }
+    _last_tick_time = now;
+}
+
+//! \details The deadline counts from the last tick, which is the time the TCPConnection's own timers are up to.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_schedule_tcp_timer() {
+    if (_tcp_timer.has_value()) {
+        _timers.cancel(_tcp_timer.value());
+        _tcp_timer.reset();
+    }
+    const auto timeout = _tcp.value().time_until_next_timeout();
+    if (timeout.has_value()) {
+        _tcp_timer = _timers.add(_last_tick_time + timeout.value(), [&] {
+            _tcp_timer.reset();
+            _tick_tcp();
+        });
+    }
+}
+
+//! \details Called from the TCPConnection thread when the owner signals `_wakeup`, and before bytes from the owner
+//! are written to the TCPConnection (they may be read before the signal is).
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_update_cork() {
+    const bool corked = _cork_requested.load();
+    if (corked == _corked) {
+        return;
+    }
+    _corked = corked;
+    if (corked) {
+        _tcp->cork();
+    } else {
+        _tcp->uncork();
     }
 }
 
@@ -45,13 +92,24 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _wakeup(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
     _thread_data.set_blocking(false);
 }
 
+//! \details Writes to the eventfd directly, rather than through `_wakeup`, whose counters belong to the
+//! TCPConnection thread.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_wake_tcp_thread() {
+    const uint64_t one = 1;
+    SystemCall("write", static_cast<int>(::write(_wakeup.fd_num(), &one, sizeof(one))));
+}
+
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _last_tick_time = timestamp_ms();
+    _timers = TimerWheel{_last_tick_time};
 
     // Set up the event loop
 
@@ -70,32 +128,39 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     //
     // 4) Outbound segment generated by TCP (needs to be
     //    given to underlying datagram socket)
+    //
+    // 5) The owner called cork() or uncork(), or is aborting
+    //    (the loop checks the abort flag after every event)
 
     // rule 1: read from filtered packet stream and dump into TCPConnection
-    _eventloop.add_rule(_datagram_adapter,
-                        Direction::In,
-                        [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
-                            }
+    //         (the event loop reads the datagrams, several per wait with the io_uring backend)
+    _eventloop.add_datagram_rule(
+        _datagram_adapter,
+        [&](string &&datagram, const Address *source) {
+            // bring the TCPConnection up to date before it sees the segment
+            _tick_tcp();
+            auto seg = _datagram_adapter.read(move(datagram), source);
+            if (seg) {
+                _tcp->segment_received(move(seg.value()));
+            }
 
-                            // debugging output:
-                            if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
-                                cerr << "DEBUG: Outbound stream to "
-                                     << _datagram_adapter.config().destination.to_string()
-                                     << " has been fully acknowledged.\n";
-                                _fully_acked = true;
-                            }
-                        },
-                        [&] { return _tcp->active(); });
+            // debugging output:
+            if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
+                cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
+                     << " has been fully acknowledged.\n";
+                _fully_acked = true;
+            }
+        },
+        [&] { return _tcp->active(); });
 
     // rule 2: read from pipe into outbound buffer
     _eventloop.add_rule(
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            _tick_tcp();
+            _update_cork();
+            auto data = _thread_data.read(min(size_t(65536), _tcp->remaining_outbound_capacity()));
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -128,8 +193,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const BufferList buffer = inbound.peek_buffers(amount_to_write);
+            const auto bytes_written = _thread_data.write(buffer, false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -154,11 +219,21 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         Direction::Out,
                         [&] {
                             while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
+                                _datagram_adapter.write(_tcp->segments_out().front(), _eventloop);
                                 _tcp->segments_out().pop();
                             }
                         },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: wake up for the owner's cork(), uncork() or abort
+    _eventloop.add_rule(
+        _wakeup,
+        Direction::In,
+        [&] {
+            _wakeup.read(sizeof(uint64_t));  // resets the eventfd's counter
+            _update_cork();
+        },
+        [&] { return _tcp->active(); });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -182,6 +257,7 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            _wake_tcp_thread();
             _tcp_thread.join();
         }
     } catch (const exception &e) {
@@ -8,6 +8,7 @@
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tcp_over_ip.hh"
+#include "timer_wheel.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
@@ -26,6 +27,13 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Adapter to underlying datagram socket (e.g., UDP or IP)
     AdaptT _datagram_adapter;
 
+    //! [eventfd](\ref man2::eventfd) that the owner signals after cork(), uncork() or an abort, so the
+    //! TCPConnection thread, which sleeps until its next timer, notices at once
+    FileDescriptor _wakeup;
+
+    //! Wake the TCPConnection thread from the owner thread
+    void _wake_tcp_thread();
+
     //! Set up the TCPConnection and the event loop
     void _initialize_TCP(const TCPConfig &config);
 
@@ -33,11 +41,26 @@ class TCPSpongeSocket : public LocalStreamSocket {
     std::optional<TCPConnection> _tcp{};
 
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
-    EventLoop _eventloop{};
+    EventLoop _eventloop{EventLoop::Backend::IOUring};
 
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
+    //! Deadlines of the TCPConnection thread; the loop sleeps until the earliest one
+    TimerWheel _timers{};
+
+    //! The timer that ticks the TCPConnection at its next timeout
+    std::optional<TimerWheel::TimerId> _tcp_timer{};
+
+    //! When the TCPConnection was last told the time, in milliseconds
+    uint64_t _last_tick_time{0};
+
+    //! Tell the TCPConnection (and the adapter) how much time has passed since they last heard
+    void _tick_tcp();
+
+    //! Replace the TCPConnection's timer after an event may have moved its next timeout
+    void _schedule_tcp_timer();
+
     //! Main loop of TCPConnection thread
     void _tcp_main();
 
@@ -55,6 +78,13 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    std::atomic_bool _cork_requested{false};  //!< Set by the owner with cork(), cleared with uncork()
+
+    bool _corked{false};  //!< Has the TCPConnection thread passed the owner's cork() on to the TCPConnection?
+
+    //! Pass a cork() or uncork() from the owner on to the TCPConnection
+    void _update_cork();
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -70,6 +100,18 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! Send only full-sized segments until uncork(), so that small writes are coalesced (like TCP_CORK)
+    void cork() {
+        _cork_requested.store(true);
+        _wake_tcp_thread();
+    }
+
+    //! Send what was held back since cork()
+    void uncork() {
+        _cork_requested.store(false);
+        _wake_tcp_thread();
+    }
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
@@ -1,5 +1,7 @@
 #include "tcp_state.hh"
 
+#include <stdexcept>
+
 using namespace std;
 
 bool TCPState::operator==(const TCPState &other) const {
@@ -10,63 +12,64 @@ bool TCPState::operator==(const TCPState &other) const {
 bool TCPState::operator!=(const TCPState &other) const { return not operator==(other); }
 
 string TCPState::name() const {
-    return "sender=`" + _sender + "`, receiver=`" + _receiver + "`, active=" + to_string(_active) +
+    return "sender=`" + summary_name(_sender) + "`, receiver=`" + summary_name(_receiver) +
+           "`, active=" + to_string(_active) +
            ", linger_after_streams_finish=" + to_string(_linger_after_streams_finish);
 }
 
 TCPState::TCPState(const TCPState::State state) {
     switch (state) {
         case TCPState::State::LISTEN:
-            _receiver = TCPReceiverStateSummary::LISTEN;
-            _sender = TCPSenderStateSummary::CLOSED;
+            _receiver = ReceiverSummary::LISTEN;
+            _sender = SenderSummary::CLOSED;
             break;
         case TCPState::State::SYN_RCVD:
-            _receiver = TCPReceiverStateSummary::SYN_RECV;
-            _sender = TCPSenderStateSummary::SYN_SENT;
+            _receiver = ReceiverSummary::SYN_RECV;
+            _sender = SenderSummary::SYN_SENT;
             break;
         case TCPState::State::SYN_SENT:
-            _receiver = TCPReceiverStateSummary::LISTEN;
-            _sender = TCPSenderStateSummary::SYN_SENT;
+            _receiver = ReceiverSummary::LISTEN;
+            _sender = SenderSummary::SYN_SENT;
             break;
         case TCPState::State::ESTABLISHED:
-            _receiver = TCPReceiverStateSummary::SYN_RECV;
-            _sender = TCPSenderStateSummary::SYN_ACKED;
+            _receiver = ReceiverSummary::SYN_RECV;
+            _sender = SenderSummary::SYN_ACKED;
             break;
         case TCPState::State::CLOSE_WAIT:
-            _receiver = TCPReceiverStateSummary::FIN_RECV;
-            _sender = TCPSenderStateSummary::SYN_ACKED;
+            _receiver = ReceiverSummary::FIN_RECV;
+            _sender = SenderSummary::SYN_ACKED;
             _linger_after_streams_finish = false;
             break;
         case TCPState::State::LAST_ACK:
-            _receiver = TCPReceiverStateSummary::FIN_RECV;
-            _sender = TCPSenderStateSummary::FIN_SENT;
+            _receiver = ReceiverSummary::FIN_RECV;
+            _sender = SenderSummary::FIN_SENT;
             _linger_after_streams_finish = false;
             break;
         case TCPState::State::CLOSING:
-            _receiver = TCPReceiverStateSummary::FIN_RECV;
-            _sender = TCPSenderStateSummary::FIN_SENT;
+            _receiver = ReceiverSummary::FIN_RECV;
+            _sender = SenderSummary::FIN_SENT;
             break;
         case TCPState::State::FIN_WAIT_1:
-            _receiver = TCPReceiverStateSummary::SYN_RECV;
-            _sender = TCPSenderStateSummary::FIN_SENT;
+            _receiver = ReceiverSummary::SYN_RECV;
+            _sender = SenderSummary::FIN_SENT;
             break;
         case TCPState::State::FIN_WAIT_2:
-            _receiver = TCPReceiverStateSummary::SYN_RECV;
-            _sender = TCPSenderStateSummary::FIN_ACKED;
+            _receiver = ReceiverSummary::SYN_RECV;
+            _sender = SenderSummary::FIN_ACKED;
             break;
         case TCPState::State::TIME_WAIT:
-            _receiver = TCPReceiverStateSummary::FIN_RECV;
-            _sender = TCPSenderStateSummary::FIN_ACKED;
+            _receiver = ReceiverSummary::FIN_RECV;
+            _sender = SenderSummary::FIN_ACKED;
             break;
         case TCPState::State::RESET:
-            _receiver = TCPReceiverStateSummary::ERROR;
-            _sender = TCPSenderStateSummary::ERROR;
+            _receiver = ReceiverSummary::ERROR;
+            _sender = SenderSummary::ERROR;
             _linger_after_streams_finish = false;
             _active = false;
             break;
         case TCPState::State::CLOSED:
-            _receiver = TCPReceiverStateSummary::FIN_RECV;
-            _sender = TCPSenderStateSummary::FIN_ACKED;
+            _receiver = ReceiverSummary::FIN_RECV;
+            _sender = SenderSummary::FIN_ACKED;
             _linger_after_streams_finish = false;
             _active = false;
             break;
@@ -74,37 +77,135 @@ TCPState::TCPState(const TCPState::State state) {
 }
 
 TCPState::TCPState(const TCPSender &sender, const TCPReceiver &receiver, const bool active, const bool linger)
-    : _sender(state_summary(sender))
-    , _receiver(state_summary(receiver))
+    : _sender(summary(sender))
+    , _receiver(summary(receiver))
     , _active(active)
     , _linger_after_streams_finish(active ? linger : false) {}
 
-string TCPState::state_summary(const TCPReceiver &receiver) {
+string TCPState::state_summary(const TCPReceiver &receiver) { return summary_name(summary(receiver)); }
+
+string TCPState::state_summary(const TCPSender &sender) { return summary_name(summary(sender)); }
+
+TCPState::ReceiverSummary TCPState::summary(const TCPReceiver &receiver) {
     if (receiver.stream_out().error()) {
-        return TCPReceiverStateSummary::ERROR;
+        return ReceiverSummary::ERROR;
     } else if (not receiver.ackno().has_value()) {
-        return TCPReceiverStateSummary::LISTEN;
+        return ReceiverSummary::LISTEN;
     } else if (receiver.stream_out().input_ended()) {
-        return TCPReceiverStateSummary::FIN_RECV;
+        return ReceiverSummary::FIN_RECV;
     } else {
-        return TCPReceiverStateSummary::SYN_RECV;
+        return ReceiverSummary::SYN_RECV;
     }
 }
 
-string TCPState::state_summary(const TCPSender &sender) {
+TCPState::SenderSummary TCPState::summary(const TCPSender &sender) {
     if (sender.stream_in().error()) {
-        return TCPSenderStateSummary::ERROR;
+        return SenderSummary::ERROR;
     } else if (sender.next_seqno_absolute() == 0) {
-        return TCPSenderStateSummary::CLOSED;
+        return SenderSummary::CLOSED;
     } else if (sender.next_seqno_absolute() == sender.bytes_in_flight()) {
-        return TCPSenderStateSummary::SYN_SENT;
+        return SenderSummary::SYN_SENT;
     } else if (not sender.stream_in().eof()) {
-        return TCPSenderStateSummary::SYN_ACKED;
+        return SenderSummary::SYN_ACKED;
     } else if (sender.next_seqno_absolute() < sender.stream_in().bytes_written() + 2) {
-        return TCPSenderStateSummary::SYN_ACKED;
+        return SenderSummary::SYN_ACKED;
     } else if (sender.bytes_in_flight()) {
-        return TCPSenderStateSummary::FIN_SENT;
+        return SenderSummary::FIN_SENT;
     } else {
-        return TCPSenderStateSummary::FIN_ACKED;
+        return SenderSummary::FIN_ACKED;
+    }
+}
+
+const string &TCPState::summary_name(const ReceiverSummary summary) {
+    switch (summary) {
+        case ReceiverSummary::ERROR:
+            return TCPReceiverStateSummary::ERROR;
+        case ReceiverSummary::LISTEN:
+            return TCPReceiverStateSummary::LISTEN;
+        case ReceiverSummary::SYN_RECV:
+            return TCPReceiverStateSummary::SYN_RECV;
+        case ReceiverSummary::FIN_RECV:
+            return TCPReceiverStateSummary::FIN_RECV;
+    }
+    throw runtime_error("invalid TCPReceiver summary");
+}
+
+const string &TCPState::summary_name(const SenderSummary summary) {
+    switch (summary) {
+        case SenderSummary::ERROR:
+            return TCPSenderStateSummary::ERROR;
+        case SenderSummary::CLOSED:
+            return TCPSenderStateSummary::CLOSED;
+        case SenderSummary::SYN_SENT:
+            return TCPSenderStateSummary::SYN_SENT;
+        case SenderSummary::SYN_ACKED:
+            return TCPSenderStateSummary::SYN_ACKED;
+        case SenderSummary::FIN_SENT:
+            return TCPSenderStateSummary::FIN_SENT;
+        case SenderSummary::FIN_ACKED:
+            return TCPSenderStateSummary::FIN_ACKED;
+    }
+    throw runtime_error("invalid TCPSender summary");
+}
+
+//! \details The inverse of TCPState(const TCPState::State): each official state is one combination of
+//! the sender and receiver summaries plus the active and linger bits (linger is ignored once inactive).
+optional<TCPState::State> TCPState::official_state(const SenderSummary sender,
+                                                   const ReceiverSummary receiver,
+                                                   const bool active,
+                                                   const bool linger) {
+    using R = ReceiverSummary;
+    using S = SenderSummary;
+    if (not active) {
+        if (sender == S::ERROR and receiver == R::ERROR) {
+            return State::RESET;
+        }
+        if (sender == S::FIN_ACKED and receiver == R::FIN_RECV) {
+            return State::CLOSED;
+        }
+        return nullopt;
+    }
+
+    switch (receiver) {
+        case R::LISTEN:
+            if (linger and sender == S::CLOSED) {
+                return State::LISTEN;
+            }
+            if (linger and sender == S::SYN_SENT) {
+                return State::SYN_SENT;
+            }
+            break;
+        case R::SYN_RECV:
+            if (not linger) {
+                break;
+            }
+            switch (sender) {
+                case S::SYN_SENT:
+                    return State::SYN_RCVD;
+                case S::SYN_ACKED:
+                    return State::ESTABLISHED;
+                case S::FIN_SENT:
+                    return State::FIN_WAIT_1;
+                case S::FIN_ACKED:
+                    return State::FIN_WAIT_2;
+                default:
+                    break;
+            }
+            break;
+        case R::FIN_RECV:
+            switch (sender) {
+                case S::SYN_ACKED:
+                    return linger ? nullopt : optional<State>{State::CLOSE_WAIT};
+                case S::FIN_SENT:
+                    return linger ? State::CLOSING : State::LAST_ACK;
+                case S::FIN_ACKED:
+                    return linger ? optional<State>{State::TIME_WAIT} : nullopt;
+                default:
+                    break;
+            }
+            break;
+        case R::ERROR:
+            break;
     }
+    return nullopt;
 }
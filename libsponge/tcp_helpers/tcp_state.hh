@@ -4,6 +4,7 @@
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
 
+#include <optional>
 #include <string>
 
 //! \brief Summary of a TCPConnection's internal state
@@ -21,9 +22,16 @@
 //! sender/receiver states and two variables that belong to the
 //! overarching TCPConnection object.
 class TCPState {
+  public:
+    //! \brief Summary of a TCPReceiver's state (see TCPReceiverStateSummary for the descriptions)
+    enum class ReceiverSummary { ERROR, LISTEN, SYN_RECV, FIN_RECV };
+
+    //! \brief Summary of a TCPSender's state (see TCPSenderStateSummary for the descriptions)
+    enum class SenderSummary { ERROR, CLOSED, SYN_SENT, SYN_ACKED, FIN_SENT, FIN_ACKED };
+
   private:
-    std::string _sender{};
-    std::string _receiver{};
+    SenderSummary _sender{SenderSummary::CLOSED};
+    ReceiverSummary _receiver{ReceiverSummary::LISTEN};
     bool _active{true};
     bool _linger_after_streams_finish{true};
 
@@ -61,6 +69,29 @@ class TCPState {
 
     //! \brief Summarize the state of a TCPSender in a string
     static std::string state_summary(const TCPSender &receiver);
+
+    //! \name Allocation-free summaries, for use on the per-segment path
+    //!@{
+
+    //! \brief Summarize the state of a TCPReceiver
+    static ReceiverSummary summary(const TCPReceiver &receiver);
+
+    //! \brief Summarize the state of a TCPSender
+    static SenderSummary summary(const TCPSender &sender);
+
+    //! \brief Describe a receiver summary (one of the TCPReceiverStateSummary strings)
+    static const std::string &summary_name(const ReceiverSummary summary);
+
+    //! \brief Describe a sender summary (one of the TCPSenderStateSummary strings)
+    static const std::string &summary_name(const SenderSummary summary);
+
+    //! \brief The "official" state that a sender, a receiver, and the TCPConnection's active and linger bits are in
+    //! \returns std::nullopt if the combination does not correspond to any of the official states
+    static std::optional<State> official_state(const SenderSummary sender,
+                                               const ReceiverSummary receiver,
+                                               const bool active,
+                                               const bool linger);
+    //!@}
 };
 
 namespace TCPReceiverStateSummary {
@@ -1,10 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 
+#include "address.hh"
+#include "eventloop.hh"
 #include "tcp_over_ip.hh"
 #include "tun.hh"
 
 #include <optional>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -26,8 +29,36 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
+    //! Attempts to parse an IPv4 datagram already read by an EventLoop datagram rule
+    std::optional<TCPSegment> read(std::string &&datagram, const Address *) {
+        InternetDatagram ip_dgram;
+        if (ip_dgram.parse(std::move(datagram)) != ParseResult::NoError) {
+            return {};
+        }
+        return unwrap_tcp_in_ip(ip_dgram);
+    }
+
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_packet(seg, flow())); }
+
+    //! Creates an IPv4 datagram from a TCP segment and writes it through EventLoop::write_datagram
+    void write(TCPSegment &seg, EventLoop &eventloop) {
+        eventloop.write_datagram(_tun, wrap_tcp_in_packet(seg, flow()));
+    }
+
+    //! Attempts to parse an IPv4 datagram containing a TCP segment of any connection, and sets `flow` to it
+    std::optional<TCPSegment> read(std::string &&datagram, const Address *, FlowKey &flow) {
+        InternetDatagram ip_dgram;
+        if (ip_dgram.parse(std::move(datagram)) != ParseResult::NoError) {
+            return {};
+        }
+        return unwrap_tcp_in_ip(ip_dgram, flow);
+    }
+
+    //! Creates an IPv4 datagram from a TCP segment of the connection `flow` and writes it to the TUN device
+    void write(TCPSegment &seg, const FlowKey &flow, EventLoop &eventloop) {
+        eventloop.write_datagram(_tun, wrap_tcp_in_packet(seg, flow));
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -5,6 +5,8 @@
 // For Lab 2, please replace with a real implementation that passes the
 // automated checks run by `make check_lab2`.
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::segment_received(const TCPSegment &seg) {
@@ -21,7 +23,15 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     uint64_t checkpoint = header.syn ? 0 : stream_out().bytes_written() - 1;  // the index of last reassembled byte
     uint64_t abs_seqno = unwrap(header.seqno, _isn, checkpoint);
     uint64_t stream_idx = header.syn ? 0 : abs_seqno - 1;  // abs seqno 换算到 stream index，留意 SYN 为 true 的情况
-    _reassembler.push_substring(seg.payload().copy(), stream_idx, header.fin);
+    if (seg.payload().size() > 0) {
+        _latest_index = stream_idx;
+    }
+    _reassembler.push_substring(seg.payload(), stream_idx, header.fin);
+}
+
+void TCPReceiver::in_order_payload_received(const Buffer &payload) {
+    _latest_index = stream_out().bytes_written();
+    _reassembler.push_substring(payload, _latest_index, false);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -39,3 +49,41 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 }
 
 size_t TCPReceiver::window_size() const { return _capacity - stream_out().buffer_size(); }
+
+vector<TCPHeader::SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) {
+    vector<TCPHeader::SackBlock> blocks;
+    if (_reassembler.empty()) {
+        _sack_history.clear();
+        return blocks;
+    }
+    const auto ranges = _reassembler.buffered_ranges();
+    // 当前包含 index 的连续区间；已被确认（或被丢弃）时没有
+    const auto containing = [&](const uint64_t index) {
+        const auto it = upper_bound(
+            ranges.begin(), ranges.end(), index, [](const uint64_t i, const auto &range) { return i < range.first; });
+        return it != ranges.begin() && index < prev(it)->second ? prev(it) : ranges.end();
+    };
+
+    vector<pair<uint64_t, uint64_t>> reported;
+    const auto report = [&](const auto it) {
+        if (it != ranges.end() && reported.size() < max_blocks &&
+            find(reported.begin(), reported.end(), *it) == reported.end()) {
+            reported.push_back(*it);
+        }
+    };
+    // 最新收到的 block 在前，然后按时间倒序重复上次报告过的 block（它们可能已经与别的 block 合并）
+    report(containing(_latest_index));
+    for (const auto &range : _sack_history) {
+        report(containing(range.first));
+    }
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        report(it);
+    }
+
+    // stream index 换算到 seqno 时要加上 SYN 的长度
+    for (const auto &range : reported) {
+        blocks.push_back({wrap(range.first + 1, _isn), wrap(range.second + 1, _isn)});
+    }
+    _sack_history = move(reported);
+    return blocks;
+}
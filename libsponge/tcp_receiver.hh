@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -23,12 +24,24 @@ class TCPReceiver {
     bool _syn_flag;
     WrappingInt32 _isn;
 
+    //! stream index of the most recently received payload, which the first SACK block must contain
+    uint64_t _latest_index{0};
+
+    //! the stream ranges of the SACK blocks last reported, most recent first; RFC 2018 asks that later ACKs
+    //! repeat them, so that every block is reported more than once even when there are more holes than blocks
+    std::vector<std::pair<uint64_t, uint64_t>> _sack_history{};
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), _syn_flag(false), _isn(0) {}
+    //! \param backend the storage strategy of the reassembled ByteStream
+    //! \param engine the storage strategy of the StreamReassembler
+    TCPReceiver(const size_t capacity,
+                const ByteStream::Backend backend = ByteStream::Backend::BufferList,
+                const StreamReassembler::Engine engine = StreamReassembler::Engine::SortedMap)
+        : _reassembler(capacity, backend, engine), _capacity(capacity), _syn_flag(false), _isn(0) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -51,6 +64,12 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks describing the data held beyond the ackno ([RFC 2018](\ref rfc::rfc2018))
+    //! \details The block containing the most recently received segment comes first, then the blocks reported
+    //! most recently before, then any others in ascending order, up to `max_blocks` in total. The blocks are
+    //! remembered as reported, so call this once per ACK sent.
+    std::vector<TCPHeader::SackBlock> sack_blocks(const size_t max_blocks = TCPHeader::MAX_SACK_BLOCKS);
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
@@ -59,6 +78,10 @@ class TCPReceiver {
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
+    //! \brief handle the payload of a segment that starts at the ackno and carries no SYN or FIN
+    //! \details Skips the sequence number arithmetic of segment_received(); the caller has checked the rest.
+    void in_order_payload_received(const Buffer &payload);
+
     //! \name "Output" interface for the reader
     //!@{
     ByteStream &stream_out() { return _reassembler.stream_out(); }
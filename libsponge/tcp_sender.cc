@@ -11,13 +11,42 @@
 
 using namespace std;
 
+//! \returns a default configuration with the given sender options
+static TCPConfig sender_config(const size_t capacity,
+                               const uint16_t retx_timeout,
+                               const std::optional<WrappingInt32> fixed_isn,
+                               const ByteStream::Backend stream_backend) {
+    TCPConfig config;
+    config.send_capacity = capacity;
+    config.rt_timeout = retx_timeout;
+    config.fixed_isn = fixed_isn;
+    config.stream_backend = stream_backend;
+    return config;
+}
+
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
-    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
-    , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity) {}
+//! \param[in] stream_backend the storage strategy of the outgoing byte stream
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const ByteStream::Backend stream_backend)
+    : TCPSender(sender_config(capacity, retx_timeout, fixed_isn, stream_backend)) {}
+
+//! \param[in] config supplies the send capacity, retransmission timeouts, ISN, stream backend, MSS,
+//! congestion control, fast retransmit and Nagle options
+TCPSender::TCPSender(const TCPConfig &config)
+    : _isn(config.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _initial_retransmission_timeout{config.rt_timeout}
+    , _stream(config.send_capacity, config.stream_backend)
+    , _adaptive_rto(config.adaptive_rto)
+    , _min_rto(config.min_rto)
+    , _max_rto(config.max_rto)
+    , _max_payload_size(config.mss)
+    , _congestion_control(config.congestion_control, _max_payload_size)
+    , _fast_retransmit(config.fast_retransmit)
+    , _nagle(config.nagle) {}
 
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _last_ackno; }
 
@@ -35,14 +64,20 @@ void TCPSender::fill_window() {
         return;
     }
 
-    // 如果 window size 为 0，发送方按照接收窗口为 1 的情况发包
-    uint16_t current_window_size = _last_window_size == 0 ? 1 : _last_window_size;
+    // 如果 window size 为 0，发送方按照接收窗口为 1 的情况发包；同时不能超过拥塞窗口
+    uint64_t current_window_size = min(_last_window_size == 0 ? 1 : _last_window_size, _congestion_control.window());
     size_t remaining_window_size = 0;
-    while ((remaining_window_size = current_window_size - bytes_in_flight())) {
+    // 窗口可能收缩到 bytes in flight 以下，此时不能再发送
+    while (current_window_size > bytes_in_flight() &&
+           (remaining_window_size = current_window_size - bytes_in_flight())) {
         // SYN_ACKED: stream ongoing
         if (!_stream.eof() && next_seqno_absolute() > bytes_in_flight()) {
-            size_t payload_size = min(TCPConfig::MAX_PAYLOAD_SIZE, remaining_window_size);
-            seg.payload() = Buffer(_stream.read(payload_size));
+            if (hold_small_segment(remaining_window_size)) {
+                return;
+            }
+            size_t payload_size = min(_max_payload_size, remaining_window_size);
+            // payload 与写入 ByteStream 的数据共享存储，只有跨越多个 Buffer 时才需要拼接
+            seg.payload() = _stream.read_buffer(payload_size);
             if (_stream.eof() && seg.length_in_sequence_space() < remaining_window_size) {  // 能放下 FIN flag
                 seg.header().fin = true;
             }
@@ -66,9 +101,26 @@ void TCPSender::fill_window() {
     }
 }
 
+//! \details A segment is short if the buffered data would not fill it while the window would allow a full one.
+//! Nagle's algorithm ([RFC 896](\ref rfc::rfc896)) holds it while earlier data is unacknowledged, so small writes
+//! made during a round trip leave together; corking holds it until uncork(). Once the stream has ended there is
+//! nothing left to wait for, and the tail is sent.
+//! \param[in] window the room left in the window
+bool TCPSender::hold_small_segment(const size_t window) const {
+    if ((!_corked && !(_nagle && bytes_in_flight() > 0)) || _stream.input_ended()) {
+        return false;
+    }
+    return _stream.buffer_size() < min(_max_payload_size, window);
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \details An ACK is a duplicate if it carries no data, does not move the ackno or the window, and data is
+//! outstanding. The DUP_ACK_THRESHOLD-th duplicate retransmits the first outstanding segment and enters fast
+//! recovery; until everything sent before then is acknowledged, each partial ACK retransmits the next hole.
+//! During recovery the congestion window is inflated by further duplicates and deflated by partial ACKs
+//! (see CongestionControl::on_duplicate_ack).
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool pure_ack) {
     uint64_t abs_ackno = unwrap(ackno, _isn, _last_ackno);
     // 丢弃不可靠的 ack
     if (abs_ackno > _next_seqno) {
@@ -76,19 +128,38 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     }
     // 如果收到的 ackno 大于任何之前的 ackno
     if (abs_ackno > _last_ackno) {
+        // 只确认了 SYN 的 ack 不算新数据；fast recovery 期间（包括结束它的 ack）窗口不按 on_ack 增长
+        const uint64_t acked_bytes = abs_ackno - _last_ackno;
+        if (_last_ackno > 0 && !_in_recovery) {
+            _congestion_control.on_ack(acked_bytes, _current_time);
+        }
         _last_ackno = abs_ackno;
 
         // 丢弃已经被确认的 outstanding segments
-        while (!_segments_outstanding.empty()) {
-            const TCPSegment &seg = _segments_outstanding.front();
-            if (seg.header().seqno.raw_value() + seg.length_in_sequence_space() <= ackno.raw_value()) {
-                _segments_outstanding.pop();
+        const bool sampled = remove_acknowledged(abs_ackno);
+
+        _duplicate_acks = 0;
+        if (_in_recovery) {
+            if (abs_ackno >= _recovery_point) {
+                _in_recovery = false;
+                _congestion_control.on_recovery_end();
             } else {
-                break;
+                // partial ack：窗口收缩掉已确认的数据；下一个空洞也丢失了，立即重传
+                _congestion_control.on_partial_ack(acked_bytes);
+                if (_high_sacked > abs_ackno) {
+                    retransmit_next_hole();  // 有 SACK 信息时只重传空洞
+                } else {
+                    retransmit_first_outstanding();
+                }
             }
         }
 
-        _RTO = _initial_retransmission_timeout;  // 重置 RTO 为初始值
+        // 有新的 RTT 样本时按照 RFC 6298 计算 RTO；否则（Karn 算法）保持退避后的 RTO
+        if (!_adaptive_rto) {
+            _RTO = _initial_retransmission_timeout;  // 重置 RTO 为初始值
+        } else if (sampled) {
+            _RTO = _rtt.rto(_min_rto, _max_rto);
+        }
         _consecutive_retransmission_counts = 0;  // 重置连续重传计数为 0
         // outstanding segments 非空，重启定时器
         if (!_segments_outstanding.empty()) {
@@ -99,6 +170,27 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
             _timer.stop();
         }
     }
+    // 重复 ack：不携带数据，ackno 与窗口都没有变化，且有未被确认的数据
+    else if (_fast_retransmit && abs_ackno == _last_ackno && pure_ack && window_size == _last_window_size &&
+             !_segments_outstanding.empty()) {
+        _duplicate_acks++;
+        // fast retransmit，每个 recovery 期间只执行一次
+        if (_duplicate_acks == TCPConfig::DUP_ACK_THRESHOLD && !_in_recovery) {
+            _in_recovery = true;
+            _recovery_point = _next_seqno;
+            _high_rxt = 0;
+            _congestion_control.on_loss(bytes_in_flight(), _current_time);
+            // 引发重传的重复 ack 各自代表一个离开网络的 segment，窗口相应膨胀
+            _congestion_control.on_duplicate_ack(TCPConfig::DUP_ACK_THRESHOLD);
+            retransmit_first_outstanding();
+        }
+        // recovery 期间，之后的每个重复 ack 都让窗口膨胀一个 MSS，以便发送新数据维持 ack clock；
+        // 带来新的 SACK 信息时，继续重传下一个空洞
+        else if (_in_recovery) {
+            _congestion_control.on_duplicate_ack();
+            retransmit_next_hole();
+        }
+    }
     _last_window_size = window_size;
     fill_window();  // 如果 window size 有空余空间，继续发包
 }
@@ -106,16 +198,30 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call
 //! to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _current_time += ms_since_last_tick;
     _timer.tick(ms_since_last_tick);
 
     // outstanding segments 不为空，同时定时器正在运行且已经过期
     if (!_segments_outstanding.empty() && _timer.is_expired()) {
+        // 接收方可以丢弃已经 SACK 的数据（RFC 2018 第 8 节），超时后不再信任 scoreboard
+        for (auto &outstanding : _segments_outstanding) {
+            outstanding._sacked = false;
+        }
+        _high_sacked = 0;
+        _high_rxt = 0;
         // 重传最早未被确认的片段
-        _segments_out.push(_segments_outstanding.front());
-        // window size 非空
+        retransmit_first_outstanding();
+        // 超时说明重复 ack 没能修复丢包，退出 fast recovery
+        _in_recovery = false;
+        _duplicate_acks = 0;
+        // window size 非空（超时不是因为零窗口探测），说明发生了拥塞
         if (_last_window_size > 0) {
+            _congestion_control.on_timeout(bytes_in_flight(), _current_time);
             _consecutive_retransmission_counts++;  // 增加连续重传计数
             _RTO *= 2;                             // RTO 翻倍
+            if (_adaptive_rto) {
+                _RTO = min(_RTO, _max_rto);
+            }
         }
         // 重置并重启定时器
         _timer.start(_RTO);
@@ -136,12 +242,89 @@ void TCPSender::send_empty_segment() {
 
 void TCPSender::send_segment(TCPSegment &seg) {
     seg.header().seqno = next_seqno();
+    _segments_outstanding.push_back({_next_seqno,
+                                     seg.header().syn,
+                                     seg.header().fin,
+                                     seg.payload(),
+                                     seg.payload_sum(),
+                                     _current_time,
+                                     false,
+                                     false});
     _next_seqno += seg.length_in_sequence_space();
-    _segments_out.push(seg);
-    _segments_outstanding.push(seg);
+    _segments_out.push(std::move(seg));
 
     // 如果定时器没有运行，启动定时器
     if (!_timer.is_started()) {
         _timer.start(_RTO);
     }
 }
+
+void TCPSender::retransmit_first_outstanding() { retransmit(_segments_outstanding.front()); }
+
+void TCPSender::retransmit(OutstandingSegment &outstanding) {
+    outstanding._retransmitted = true;
+    _high_rxt = max(_high_rxt, outstanding.end());
+    TCPSegment seg;
+    seg.header().seqno = wrap(outstanding._seqno, _isn);
+    seg.header().syn = outstanding._syn;
+    seg.header().fin = outstanding._fin;
+    seg.set_payload(outstanding._payload, outstanding._payload_sum);
+    _segments_out.push(std::move(seg));
+}
+
+//! \details A hole is an outstanding segment that is not SACKed but lies below a SACKed one, so it was
+//! probably lost rather than still in flight. Each hole is retransmitted at most once per recovery.
+//! \returns true if a hole was retransmitted
+bool TCPSender::retransmit_next_hole() {
+    for (auto &outstanding : _segments_outstanding) {
+        if (outstanding.end() > _high_sacked) {
+            break;
+        }
+        if (!outstanding._sacked && outstanding._seqno >= _high_rxt) {
+            retransmit(outstanding);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TCPSender::sack_received(const vector<TCPHeader::SackBlock> &blocks) {
+    for (const auto &block : blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _last_ackno);
+        const uint64_t right = unwrap(block.right, _isn, _last_ackno);
+        // 忽略已经确认过的（D-SACK）和不合法的 block
+        if (left < _last_ackno || right > _next_seqno || left >= right) {
+            continue;
+        }
+        _high_sacked = max(_high_sacked, right);
+        // outstanding segments 按 seqno 排序，二分查找第一个可能被 block 包含的 segment
+        auto it = lower_bound(_segments_outstanding.begin(),
+                              _segments_outstanding.end(),
+                              left,
+                              [](const OutstandingSegment &seg, const uint64_t seqno) { return seg._seqno < seqno; });
+        for (; it != _segments_outstanding.end() && it->end() <= right; ++it) {
+            it->_sacked = true;
+        }
+    }
+}
+
+//! \param[in] abs_ackno the absolute ackno; every sequence number before it has been received
+//! \details Fully acknowledged segments are popped from the front, so each segment is visited once.
+//! A segment that is only partly acknowledged stays outstanding and is retransmitted whole;
+//! bytes_in_flight() already accounts for the acknowledged part, and the receiver trims the duplicate bytes.
+//! \returns true if the ack yielded an RTT sample: the time since the newest acknowledged segment was sent,
+//! provided that no acknowledged segment was ever retransmitted (Karn's rule)
+bool TCPSender::remove_acknowledged(const uint64_t abs_ackno) {
+    bool any_retransmitted = false;
+    optional<uint64_t> newest_sent_time{};
+    while (!_segments_outstanding.empty() && _segments_outstanding.front().end() <= abs_ackno) {
+        any_retransmitted |= _segments_outstanding.front()._retransmitted;
+        newest_sent_time = _segments_outstanding.front()._sent_time;
+        _segments_outstanding.pop_front();
+    }
+    if (any_retransmitted || !newest_sent_time.has_value()) {
+        return false;
+    }
+    _rtt.add_sample(_current_time - newest_sent_time.value());
+    return true;
+}
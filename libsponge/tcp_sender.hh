@@ -2,10 +2,14 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <functional>
 #include <queue>
 
@@ -34,8 +38,9 @@ class RetransmissionTimer {
         }
     }
 
-    bool is_expired() { return _is_expired && _is_started; }
-    bool is_started() { return _is_started; }
+    bool is_expired() const { return _is_expired && _is_started; }
+    bool is_started() const { return _is_started; }
+    unsigned int remaining_time() const { return _is_expired ? 0 : _remaining_time; }
 
   private:
     unsigned int _remaining_time{0};
@@ -43,6 +48,45 @@ class RetransmissionTimer {
     bool _is_started{false};
 };
 
+//! \brief Smoothed round-trip time and its variation, from which the retransmission timeout is derived
+//! ([RFC 6298](\ref rfc::rfc6298)). All times are in milliseconds.
+class RTTEstimator {
+  public:
+    void add_sample(const uint64_t rtt) {
+        const double r = static_cast<double>(rtt);
+        if (_samples == 0) {  // 第一个样本
+            _srtt = r;
+            _rttvar = r / 2;
+            _min_rtt = rtt;
+        } else {  // alpha = 1/8, beta = 1/4
+            _rttvar = 0.75 * _rttvar + 0.25 * std::abs(_srtt - r);
+            _srtt = 0.875 * _srtt + 0.125 * r;
+            _min_rtt = std::min(_min_rtt, rtt);
+        }
+        _latest_rtt = rtt;
+        _samples++;
+    }
+
+    //! RTO = SRTT + max(G, 4 * RTTVAR) with a clock granularity G of 1 ms, clamped to [min_rto, max_rto]
+    unsigned int rto(const unsigned int min_rto, const unsigned int max_rto) const {
+        const double rto = _srtt + std::max(1.0, 4 * _rttvar);
+        return static_cast<unsigned int>(std::clamp(rto, double(min_rto), double(max_rto)));
+    }
+
+    double srtt() const { return _srtt; }
+    double rttvar() const { return _rttvar; }
+    uint64_t min_rtt() const { return _min_rtt; }
+    uint64_t latest_rtt() const { return _latest_rtt; }
+    uint64_t samples() const { return _samples; }  //!< no other field is meaningful while this is 0
+
+  private:
+    double _srtt{0};
+    double _rttvar{0};
+    uint64_t _min_rtt{0};
+    uint64_t _latest_rtt{0};
+    uint64_t _samples{0};
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -50,6 +94,23 @@ class RetransmissionTimer {
 //! maintains the Retransmission Timer, and retransmits in-flight
 //! segments if the retransmission timer expires.
 class TCPSender {
+  private:
+    //! \brief A segment that has been sent but not yet fully acknowledged
+    //! \details Only the fields the sender sets are kept; the payload shares storage with the copy that was sent.
+    struct OutstandingSegment {
+        uint64_t _seqno;  //!< absolute seqno of the segment (the SYN, if `_syn` is set)
+        bool _syn;
+        bool _fin;
+        Buffer _payload;
+        uint16_t _payload_sum;  //!< TCPSegment::payload_sum() of `_payload`, so retransmissions need not sum it again
+        uint64_t _sent_time;  //!< when the segment was first sent, in milliseconds
+        bool _retransmitted;  //!< Karn's rule: the ack of a retransmitted segment is not an RTT sample
+        bool _sacked;         //!< the receiver reported holding the whole segment in a SACK block
+
+        //! index just past the last sequence number of the segment
+        uint64_t end() const { return _seqno + _payload.size() + (_syn ? 1 : 0) + (_fin ? 1 : 0); }
+    };
+
   private:
     //! our initial sequence number, the number for our SYN.
     WrappingInt32 _isn;
@@ -68,23 +129,63 @@ class TCPSender {
 
   private:
     unsigned int _RTO{_initial_retransmission_timeout};  // current retransmission timeout
+    bool _adaptive_rto;                                   // 使用 RTT 估计的 RTO，而不是每次 ack 后重置为初始值
+    unsigned int _min_rto;
+    unsigned int _max_rto;
+    RTTEstimator _rtt{};
     unsigned int _consecutive_retransmission_counts{0};  // the number of consecutive retransmissions
 
     // 上一次接收到的
     uint64_t _last_ackno{0};
-    uint16_t _last_window_size{1};
+    uint64_t _last_window_size{1};                          // 已经按 window scale 放大后的窗口
+    size_t _max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};  // 每个 segment 的最大 payload（MSS）
+
+    uint64_t _current_time{0};  // 累计的 tick 时间，单位毫秒
+
+    //! limits the bytes in flight along with the receiver's window
+    CongestionControl _congestion_control;
+
+    //! \name Fast retransmit and NewReno fast recovery ([RFC 6582](\ref rfc::rfc6582))
+    //!@{
+    bool _fast_retransmit;
+    unsigned int _duplicate_acks{0};  //!< duplicate ACKs received since the ackno last advanced
+    bool _in_recovery{false};         //!< a fast retransmit happened, and not everything sent before it is acked
+    uint64_t _recovery_point{0};      //!< the absolute seqno that ends fast recovery once acknowledged
+    //!@}
+
+    //! \name SACK scoreboard ([RFC 2018](\ref rfc::rfc2018)); segments themselves carry the `_sacked` marks
+    //!@{
+    uint64_t _high_sacked{0};  //!< one past the highest absolute seqno reported in a SACK block
+    uint64_t _high_rxt{0};     //!< one past the highest absolute seqno retransmitted in this recovery
+    //!@}
+
+    //! \name Coalescing of small writes: a segment shorter than the MSS waits while either holds it back
+    //!@{
+    bool _nagle;          //!< RFC 896: while data is unacknowledged
+    bool _corked{false};  //!< TCP_CORK: until uncork()
+    //!@}
 
     RetransmissionTimer _timer{};
 
-    std::queue<TCPSegment> _segments_outstanding{};
+    //! outstanding segments in order of absolute seqno (they never overlap)
+    std::deque<OutstandingSegment> _segments_outstanding{};
 
     void send_segment(TCPSegment &seg);
+    bool remove_acknowledged(const uint64_t abs_ackno);
+    void retransmit_first_outstanding();
+    void retransmit(OutstandingSegment &outstanding);
+    bool retransmit_next_hole();
+    bool hold_small_segment(const size_t window) const;
 
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const ByteStream::Backend stream_backend = ByteStream::Backend::BufferList);
+
+    //! Initialize a TCPSender with every sender option of a configuration
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -96,7 +197,12 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \note `window_size` is the effective window, i.e. already scaled if window scaling is in use
+    //! \param pure_ack false if the segment also occupied sequence space; such a segment is never a duplicate ACK
+    void ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool pure_ack = true);
+
+    //! \brief SACK blocks arrived with the next acknowledgment (call before ack_received())
+    void sack_received(const std::vector<TCPHeader::SackBlock> &blocks);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -106,6 +212,23 @@ class TCPSender {
 
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Set the largest payload to put in one segment (e.g. once the MSS has been negotiated)
+    void set_max_payload_size(const size_t size) {
+        _max_payload_size = size;
+        _congestion_control.set_mss(size);
+    }
+
+    //! \brief Hold back segments shorter than the MSS until uncork() (the end of the stream still flushes them)
+    void cork() { _corked = true; }
+
+    //! \brief Stop holding back short segments, and send what the window allows (once the SYN has been sent)
+    void uncork() {
+        _corked = false;
+        if (_next_seqno > 0) {
+            fill_window();
+        }
+    }
     //!@}
 
     //! \name Accessors
@@ -119,6 +242,38 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Are segments shorter than the MSS being held back until uncork()?
+    bool corked() const { return _corked; }
+
+    //! \brief Is the sender in fast recovery (repairing a loss found by duplicate ACKs)?
+    bool in_fast_recovery() const { return _in_recovery; }
+
+    //! \brief The first sequence number not yet acknowledged (SND.UNA)
+    WrappingInt32 unacknowledged_seqno() const { return wrap(_last_ackno, _isn); }
+
+    //! \brief The peer's window as of the latest acknowledgment (SND.WND), already scaled
+    uint64_t window_size() const { return _last_window_size; }
+
+    //! \brief The current retransmission timeout, in milliseconds
+    unsigned int retransmission_timeout() const { return _RTO; }
+
+    //! \brief Milliseconds until the retransmission timer expires, or nothing if it is not running
+    std::optional<size_t> time_until_timeout() const {
+        if (_segments_outstanding.empty() || !_timer.is_started()) {
+            return {};
+        }
+        return _timer.remaining_time();
+    }
+
+    //! \brief Round-trip time statistics, sampled from acknowledged segments that were sent only once
+    const RTTEstimator &rtt() const { return _rtt; }
+
+    //! \brief The largest payload the sender puts in one segment
+    size_t max_payload_size() const { return _max_payload_size; }
+
+    //! \brief The congestion window and the policy that adjusts it
+    const CongestionControl &congestion_control() const { return _congestion_control; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
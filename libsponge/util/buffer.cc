@@ -7,7 +7,17 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
+        _storage.reset();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _ending_offset += n;
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
         _storage.reset();
     }
 }
@@ -18,6 +28,17 @@ void BufferList::append(const BufferList &other) {
     }
 }
 
+void BufferList::append(BufferList &&other) {
+    if (_buffers.empty()) {
+        _buffers = std::move(other._buffers);
+        return;
+    }
+    for (auto &buf : other._buffers) {
+        _buffers.push_back(std::move(buf));
+    }
+    other._buffers.clear();
+}
+
 BufferList::operator Buffer() const {
     switch (_buffers.size()) {
         case 0:
@@ -70,6 +91,21 @@ BufferViewList::BufferViewList(const BufferList &buffers) {
     }
 }
 
+//! \param[in] n is the length of the header about to be written
+char *PacketBuffer::prepend(const size_t n) {
+    if (n > _headers_start) {
+        throw out_of_range("PacketBuffer::prepend");
+    }
+    _headers_start -= n;
+    return _headroom.data() + _headers_start;
+}
+
+BufferViewList::BufferViewList(const PacketBuffer &packet) : _views{packet.headers()} {
+    if (packet.payload().size() > 0) {
+        _views.push_back(packet.payload());
+    }
+}
+
 void BufferViewList::remove_prefix(size_t n) {
     while (n > 0) {
         if (_views.empty()) {
@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <memory>
 #include <numeric>
@@ -16,6 +17,7 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _ending_offset{};  //!< Number of bytes discarded from the back of `_storage`
 
   public:
     Buffer() = default;
@@ -29,7 +31,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _ending_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +49,10 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer that share the storage still see the discarded bytes.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -80,6 +86,9 @@ class BufferList {
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief Append a BufferList, moving its Buffers instead of copying the references
+    void append(BufferList &&other);
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
@@ -94,6 +103,43 @@ class BufferList {
     std::string concatenate() const;
 };
 
+//! \brief A packet whose headers are written in place, into headroom reserved in front of the payload
+//! \details Like the Linux kernel's `sk_buff`: each layer prepend()s its header in front of the headers already
+//! there, so the packet is one contiguous run of headers plus the payload, and goes out in one or two pieces
+//! without building a string per header.
+class PacketBuffer {
+  public:
+    static constexpr size_t HEADROOM = 128;  //!< room for the largest IPv4 header (60 bytes) and TCP header (60 bytes)
+
+  private:
+    std::array<char, HEADROOM> _headroom{};
+    size_t _headers_start{HEADROOM};  //!< offset in `_headroom` of the outermost header
+    Buffer _payload{};
+
+  public:
+    PacketBuffer() = default;
+
+    //! \brief Construct with no headers yet, sharing the payload's storage
+    explicit PacketBuffer(const Buffer &payload) : _payload(payload) {}
+
+    //! \brief Reserve `n` bytes in front of the headers already written
+    //! \returns where to write the new header
+    //! \note Throws an exception if the headroom is exhausted
+    char *prepend(const size_t n);
+
+    //! \brief The headers written so far, outermost first
+    std::string_view headers() const { return {_headroom.data() + _headers_start, HEADROOM - _headers_start}; }
+
+    //! \brief The payload, behind the headers
+    const Buffer &payload() const { return _payload; }
+
+    //! \brief Size of the packet: headers plus payload
+    size_t size() const { return HEADROOM - _headers_start + _payload.size(); }
+
+    //! \brief Make a copy to a new std::string
+    std::string concatenate() const { return std::string(headers()).append(_payload.str()); }
+};
+
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
     std::deque<std::string_view> _views{};
@@ -111,6 +157,9 @@ class BufferViewList {
     //! \brief Construct from a BufferList
     BufferViewList(const BufferList &buffers);
 
+    //! \brief Construct from a PacketBuffer: the headers, then the payload
+    BufferViewList(const PacketBuffer &packet);
+
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
     //!@}
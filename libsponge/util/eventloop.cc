@@ -2,9 +2,16 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
 #include <stdexcept>
+#include <sys/stat.h>
 #include <system_error>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
@@ -14,6 +21,76 @@ unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+//! \param[in] backend is the system call used to wait for the file descriptors
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (_backend == Backend::IOUring and not IOUring::available()) {
+        _backend = Backend::Epoll;
+    }
+
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+
+    if (_backend == Backend::IOUring) {
+        _ring.emplace(RING_ENTRIES);
+        _buffers.resize(READ_SLOTS * MAX_DATAGRAM_SIZE + WRITE_SLOTS * WRITE_SLOT_SIZE);
+        vector<iovec> buffers;
+        for (size_t slot = 0; slot < READ_SLOTS + WRITE_SLOTS; slot++) {
+            buffers.push_back({slot_buffer(slot), slot < READ_SLOTS ? MAX_DATAGRAM_SIZE : WRITE_SLOT_SIZE});
+            (slot < READ_SLOTS ? _free_read_slots : _free_write_slots).push_back(slot);
+        }
+        try {
+            _ring->register_buffers(buffers);
+            _fixed_buffers = true;
+        } catch (const unix_error &e) {
+            // 例如超过 RLIMIT_MEMLOCK：同样的缓冲区，用不需要注册的请求
+        }
+    }
+}
+
+EventLoop::~EventLoop() {
+    if (not _ring.has_value()) {
+        return;
+    }
+    try {
+        // 已经取出、还没处理的完成：请求已经结束，不会再有完成可等
+        for (const auto &completion : _completions) {
+            const auto operation = _operations.find(completion.user_data);
+            if (operation == _operations.end()) {
+                continue;
+            }
+            if (operation->second.kind == Operation::Kind::Read) {
+                _free_read_slots.push_back(operation->second.slot);
+            }
+            _operations.erase(operation);
+        }
+        _completions.clear();
+
+        // 写会很快完成；读和 poll 可能永远等下去
+        for (const auto &[user_data, operation] : _operations) {
+            if (operation.kind != Operation::Kind::Write) {
+                cancel_operation(user_data);
+            }
+        }
+        while (not _operations.empty()) {
+            _ring->submit(true);
+            IOUring::Completion completion{};
+            while (_ring->next_completion(completion)) {
+                _operations.erase(completion.user_data);
+            }
+        }
+    } catch (const exception &e) {
+        // don't throw an exception from the destructor
+        cerr << "Exception destructing EventLoop: " << e.what() << endl;
+    }
+}
+
+char *EventLoop::slot_buffer(const size_t slot) {
+    const size_t offset = slot < READ_SLOTS ? slot * MAX_DATAGRAM_SIZE
+                                            : READ_SLOTS * MAX_DATAGRAM_SIZE + (slot - READ_SLOTS) * WRITE_SLOT_SIZE;
+    return &_buffers.at(offset);
+}
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
@@ -25,7 +102,170 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const CallbackT &callback,
                          const InterestT &interest,
                          const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    add({fd.duplicate(), direction, callback, interest, cancel, false, {}, false, false, {}, {}});
+}
+
+//! \param[in] fd is the FileDescriptor to read datagrams from
+//! \param[in] callback is called with each datagram, and its source address if `fd` is a socket
+//! \param[in] interest is called by EventLoop::wait_next_event, as for add_rule()
+//! \param[in] cancel is called when the rule is cancelled (e.g. on EOF, or closure).
+void EventLoop::add_datagram_rule(const FileDescriptor &fd,
+                                  const DatagramCallbackT &callback,
+                                  const InterestT &interest,
+                                  const CallbackT &cancel) {
+    struct stat status {};
+    SystemCall("fstat", ::fstat(fd.fd_num(), &status));
+    const bool is_socket = S_ISSOCK(status.st_mode);
+    Rule rule{fd.duplicate(), Direction::In, {}, interest, cancel, false, callback, is_socket, false, {}, {}};
+
+    if (_ring.has_value()) {
+        // 缓冲区用完时，像其他后端一样在 fd 就绪时读取
+        const size_t slots = min(READS_PER_RULE, _free_read_slots.size());
+        rule.ring_reads = slots > 0;
+        rule.read_slots.assign(_free_read_slots.end() - slots, _free_read_slots.end());
+        _free_read_slots.resize(_free_read_slots.size() - slots);
+    }
+
+    add(move(rule));
+}
+
+//! \details With Backend::Epoll and Backend::IOUring, also files the rule under its fd, and starts watching it at
+//! once unless it has an interest callback.
+void EventLoop::add(Rule &&new_rule) {
+    if (_backend != Backend::Poll) {
+        // fd 号码可能被复用：旧的 fd 已经关闭，它的规则不会再触发
+        const auto reg = _registrations.find(new_rule.fd.fd_num());
+        if (reg != _registrations.end() and reg->second.rules.front()->fd.closed()) {
+            for (const auto rule : vector<RuleIter>(reg->second.rules)) {
+                cancel_rule(rule);
+            }
+        }
+    }
+
+    _rules.push_back(move(new_rule));
+
+    if (_backend != Backend::Poll) {
+        const RuleIter rule = prev(_rules.end());
+        _registrations[rule->fd.fd_num()].rules.push_back(rule);
+        if (rule->interest) {
+            _dynamic_rules.push_back(rule);  // 在每次 wait_next_event() 时询问
+        } else {
+            set_interest(rule, true);
+        }
+    }
+}
+
+//! \details Registers the fd with epoll, or changes its events, if the interested directions changed.
+//! A datagram rule that reads with requests in the ring gets its reads instead.
+void EventLoop::set_interest(const RuleIter rule, const bool interested) {
+    if (rule->interested == interested) {
+        return;
+    }
+    rule->interested = interested;
+    if (interested) {
+        _interested_rules++;
+    } else {
+        _interested_rules--;
+    }
+
+    if (rule->ring_reads) {
+        if (interested) {
+            post_reads(rule);
+        } else {
+            cancel_reads(rule);
+        }
+        return;
+    }
+    update_registration(rule->fd.fd_num());
+}
+
+//! \details Asks the rules with an interest callback again, and cancels those that can never trigger again.
+void EventLoop::update_interests() {
+    for (size_t i = 0; i < _dynamic_rules.size();) {
+        const RuleIter rule = _dynamic_rules[i];
+        if (rule->is_defunct()) {
+            cancel_rule(rule);  // 从 _dynamic_rules 中移除，下标不变
+            continue;
+        }
+        set_interest(rule, rule->interest());
+        ++i;
+    }
+}
+
+void EventLoop::update_registration(const int fd_num) {
+    Registration &reg = _registrations.at(fd_num);
+    uint32_t events = 0;
+    for (const auto &rule : reg.rules) {
+        if (rule->interested and not rule->ring_reads) {
+            events |= rule->direction == Direction::In ? EPOLLIN : EPOLLOUT;
+        }
+    }
+    if (_backend == Backend::IOUring) {
+        update_poll(reg, fd_num, events);
+        return;
+    }
+
+    if (reg.registered and events == reg.events) {
+        return;
+    }
+    reg.events = events;
+    if (reg.always_ready) {
+        return;
+    }
+
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd_num;
+    if (reg.registered) {
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event));
+    } else if (SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event), EPERM) < 0) {
+        // 普通文件不支持 epoll；poll(2) 总是报告它们就绪
+        reg.always_ready = true;
+    }
+    reg.registered = true;
+}
+
+//! \details Calls Rule::cancel and deletes the rule, unregistering its fd if no other rule uses it.
+void EventLoop::cancel_rule(const RuleIter rule) {
+    rule->cancel();
+
+    const int fd_num = rule->fd.fd_num();
+    if (rule->interested) {
+        _interested_rules--;
+        rule->interested = false;
+    }
+    Registration &reg = _registrations.at(fd_num);
+    reg.rules.erase(find(reg.rules.begin(), reg.rules.end(), rule));
+    if (rule->interest) {
+        _dynamic_rules.erase(find(_dynamic_rules.begin(), _dynamic_rules.end(), rule));
+    }
+
+    if (rule->ring_reads) {
+        // 已经提交的读：取消，它们的缓冲区在完成时归还
+        cancel_reads(rule);
+        for (auto &[user_data, operation] : _operations) {
+            if (operation.kind == Operation::Kind::Read and operation.rule == rule) {
+                operation.rule.reset();
+            }
+        }
+        _free_read_slots.insert(_free_read_slots.end(), rule->read_slots.begin(), rule->read_slots.end());
+        _pending_datagrams -= rule->pending.size();
+    }
+
+    // 已经关闭的 fd 会被内核自动移出 epoll（io_uring 的 poll 则持有文件的引用）
+    if (reg.rules.empty()) {
+        if (_backend == Backend::Epoll and reg.registered and not reg.always_ready and not rule->fd.closed()) {
+            ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr);
+        }
+        if (_backend == Backend::IOUring) {
+            update_poll(reg, fd_num, 0);
+        }
+        _registrations.erase(fd_num);
+    } else if (not rule->fd.closed()) {
+        update_registration(fd_num);
+    }
+
+    _rules.erase(rule);
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -59,13 +299,24 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    switch (_backend) {
+        case Backend::Epoll:
+            return wait_epoll(timeout_ms);
+        case Backend::IOUring:
+            return wait_io_uring(timeout_ms);
+        default:
+            return wait_poll(timeout_ms);
+    }
+}
+
+EventLoop::Result EventLoop::wait_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
 
     // set up the pollfd for each rule
     for (auto it = _rules.cbegin(); it != _rules.cend();) {  // NOTE: it gets erased or incremented in loop body
-        const auto &this_rule = *it;
+        auto &this_rule = *it;
         if (this_rule.direction == Direction::In && this_rule.fd.eof()) {
             // no more reading on this rule, it's reached eof
             this_rule.cancel();
@@ -79,7 +330,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             continue;
         }
 
-        if (this_rule.interest()) {
+        if (this_rule.is_interested()) {
             pollfds.push_back({this_rule.fd.fd_num(), static_cast<short>(this_rule.direction), 0});
             something_to_poll = true;
         } else {
@@ -114,7 +365,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             throw runtime_error("EventLoop: error on polled file descriptor");
         }
 
-        const auto &this_rule = *it;
+        auto &this_rule = *it;
         const auto poll_ready = static_cast<bool>(this_pollfd.revents & this_pollfd.events);
         const auto poll_hup = static_cast<bool>(this_pollfd.revents & POLLHUP);
         if (poll_hup && this_pollfd.events && !poll_ready) {
@@ -126,13 +377,15 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             continue;
         }
 
-        if (poll_ready) {
+        if (poll_ready and this_rule.datagram) {
+            read_datagram(this_rule);
+        } else if (poll_ready) {
             // we only want to call callback if revents includes the event we asked for
             const auto count_before = this_rule.service_count();
             this_rule.callback();
 
             // only check for busy wait if we're not canceling or exiting
-            if (count_before == this_rule.service_count() and this_rule.interest()) {
+            if (count_before == this_rule.service_count() and this_rule.is_interested()) {
                 throw runtime_error(
                     "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
             }
@@ -143,3 +396,432 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \details Same contract as with Backend::Poll, but only the rules with an interest callback are visited before
+//! waiting, and only the rules of ready fds after. A rule without an interest callback is canceled once its
+//! callback leaves the fd at EOF or closed.
+EventLoop::Result EventLoop::wait_epoll(const int timeout_ms) {
+    update_interests();
+
+    // quit if there is nothing left to poll
+    if (_interested_rules == 0) {
+        return Result::Exit;
+    }
+
+    // epoll 不接受的 fd（普通文件）总是就绪，此时不等待
+    vector<epoll_event> always_ready;
+    for (const auto &[fd_num, reg] : _registrations) {
+        if (reg.always_ready and reg.events) {
+            epoll_event event{};
+            event.events = reg.events;
+            event.data.fd = fd_num;
+            always_ready.push_back(event);
+        }
+    }
+
+    _events.resize(max(_registrations.size(), size_t(1)));
+    int ready = 0;
+    try {
+        ready = SystemCall("epoll_wait",
+                           ::epoll_wait(_epoll->fd_num(),
+                                        _events.data(),
+                                        static_cast<int>(_events.size()),
+                                        always_ready.empty() ? timeout_ms : 0));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    _events.resize(ready);
+    _events.insert(_events.end(), always_ready.begin(), always_ready.end());
+    if (_events.empty()) {
+        return Result::Timeout;
+    }
+
+    for (const auto &event : _events) {
+        const auto reg = _registrations.find(event.data.fd);
+        if (reg == _registrations.end()) {
+            continue;  // 之前的回调取消了它的全部规则
+        }
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // 回调可能添加规则，所以遍历副本
+        for (const RuleIter rule : vector<RuleIter>(reg->second.rules)) {
+            if (rule->interested) {
+                handle_ready(rule, event.events);
+            }
+        }
+    }
+
+    return Result::Success;
+}
+
+//! \param[in] rule is an interested rule of a ready fd
+//! \param[in] revents is what epoll or the poll request reported (EPOLLIN has the value of POLLIN, and so on)
+void EventLoop::handle_ready(const RuleIter rule, const uint32_t revents) {
+    const uint32_t wanted = rule->direction == Direction::In ? EPOLLIN : EPOLLOUT;
+    if (not(revents & wanted)) {
+        if (revents & EPOLLHUP) {
+            // the only condition was a hangup: this direction of the fd is defunct
+            cancel_rule(rule);
+        }
+        return;
+    }
+
+    if (rule->datagram) {
+        read_datagram(*rule);
+    } else {
+        const auto count_before = rule->service_count();
+        rule->callback();
+
+        // only check for busy wait if we're not canceling or exiting
+        if (not rule->is_defunct() and count_before == rule->service_count() and rule->is_interested()) {
+            throw runtime_error(
+                "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+        }
+    }
+
+    if (rule->is_defunct()) {
+        cancel_rule(rule);
+    }
+}
+
+//! \details Reads into a buffer that is kept from call to call, and hands the callback a copy of just the
+//! datagram (FileDescriptor::read would first resize a string to the largest possible read).
+void EventLoop::read_datagram(Rule &rule) {
+    _datagram_buffer.resize(MAX_DATAGRAM_SIZE);
+    Address::Raw source;
+    socklen_t source_size = sizeof(source.storage);
+    const ssize_t length =
+        rule.is_socket ? SystemCall("recvfrom",
+                                    ::recvfrom(rule.fd.fd_num(),
+                                               _datagram_buffer.data(),
+                                               _datagram_buffer.size(),
+                                               MSG_TRUNC,
+                                               source,
+                                               &source_size))
+                       : SystemCall("read", ::read(rule.fd.fd_num(), _datagram_buffer.data(), _datagram_buffer.size()));
+    rule.fd.register_read();
+
+    if (length > ssize_t(_datagram_buffer.size())) {
+        throw runtime_error("recvfrom (oversized datagram)");
+    }
+    if (length == 0 and not rule.is_socket) {
+        rule.fd._internal_fd->_eof = true;
+        return;
+    }
+
+    string datagram(_datagram_buffer.data(), length);
+    if (rule.is_socket and source_size > 0) {  // 已连接的 socket 可能不给出来源
+        const Address address{source, source_size};
+        rule.datagram(move(datagram), &address);
+    } else {
+        rule.datagram(move(datagram), nullptr);
+    }
+}
+
+//! \param[in] fd is the FileDescriptor to write to
+//! \param[in] datagram is the datagram, which is written whole
+//! \param[in] destination is the address to send it to, if `fd` is an unconnected socket
+void EventLoop::write_datagram(FileDescriptor &fd, const BufferViewList &datagram, const Address *destination) {
+    if (_ring.has_value() and datagram.size() <= WRITE_SLOT_SIZE) {
+        if (_free_write_slots.empty()) {
+            // 排队的写通常在 io_uring_enter 中立即完成并归还缓冲区
+            _ring->submit();
+            take_completions();
+        }
+        if (not _free_write_slots.empty()) {
+            const size_t slot = _free_write_slots.back();
+            _free_write_slots.pop_back();
+            char *const buffer = slot_buffer(slot);
+            size_t size = 0;
+            for (const auto &view : datagram.as_iovecs()) {
+                memcpy(buffer + size, view.iov_base, view.iov_len);
+                size += view.iov_len;
+            }
+
+            // 同一个 fd 上连续排队的写链接起来：即使前一个遇到 EAGAIN 要稍后重试，后一个也不会越过它
+            if (fd.fd_num() == _last_write_fd) {
+                _ring->link_last(_last_write);
+            }
+            const uint64_t user_data = _next_operation++;
+            _last_write = user_data;
+            _last_write_fd = fd.fd_num();
+            Operation &write =
+                _operations.emplace(user_data, Operation{Operation::Kind::Write, fd.fd_num(), {}, slot, {}, {}, {}})
+                    .first->second;
+            write.iov = {buffer, size};
+            if (destination) {
+                memcpy(&write.address.storage, static_cast<const sockaddr *>(*destination), destination->size());
+                write.message.msg_name = &write.address.storage;
+                write.message.msg_namelen = destination->size();
+                write.message.msg_iov = &write.iov;
+                write.message.msg_iovlen = 1;
+                io_uring_sqe &sqe = _ring->prepare(IORING_OP_SENDMSG, fd.fd_num(), user_data);
+                sqe.addr = reinterpret_cast<uint64_t>(&write.message);
+                sqe.len = 1;
+            } else {
+                io_uring_sqe &sqe =
+                    _ring->prepare(_fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd.fd_num(), user_data);
+                sqe.addr = reinterpret_cast<uint64_t>(buffer);
+                sqe.len = size;
+                sqe.off = numeric_limits<uint64_t>::max();  // 当前位置
+                sqe.buf_index = slot;
+            }
+            fd.register_write();
+            return;
+        }
+    }
+
+    // 先提交排队的写，免得这个数据报越过它们
+    if (_ring.has_value()) {
+        _ring->submit();
+    }
+    if (not destination) {
+        fd.write(datagram);
+        return;
+    }
+    auto iovecs = datagram.as_iovecs();
+    msghdr message{};
+    message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(*destination));
+    message.msg_namelen = destination->size();
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = iovecs.size();
+    const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd.fd_num(), &message, 0));
+    if (size_t(bytes_sent) != datagram.size()) {
+        throw runtime_error("datagram payload too big for sendmsg()");
+    }
+    fd.register_write();
+}
+
+//! \details Same contract as with Backend::Epoll. The requests prepared since the last wait (new polls, reads,
+//! queued writes) are submitted by the same system call that waits; each completion is then handled like a
+//! ready fd (polls), a datagram for the rule's callback (reads), or a buffer to reuse (writes).
+EventLoop::Result EventLoop::wait_io_uring(const int timeout_ms) {
+    update_interests();
+
+    // quit if there is nothing left to poll
+    if (_interested_rules == 0) {
+        // 排队的写（和取消）仍然要交给内核；完成留在队列里，不再取出没有人处理的读和 poll
+        _ring->submit();
+        return Result::Exit;
+    }
+
+    // 之前收到的完成，以及不感兴趣时读到的数据报，不需要等待
+    take_completions();
+    bool deliverable = false;
+    if (_pending_datagrams > 0) {
+        for (const auto &rule : _dynamic_rules) {
+            deliverable |= rule->interested and not rule->pending.empty();
+        }
+    }
+    const bool ready = deliverable or not _completions.empty();
+    if (not _ring->submit(not ready, timeout_ms)) {
+        return Result::Exit;
+    }
+    take_completions();
+    if (_completions.empty() and not deliverable) {
+        return Result::Timeout;
+    }
+
+    if (deliverable) {
+        for (const RuleIter rule : vector<RuleIter>(_dynamic_rules)) {
+            while (rule->interested and not rule->pending.empty() and rule->is_interested()) {
+                auto [datagram, source] = move(rule->pending.front());
+                rule->pending.pop_front();
+                _pending_datagrams--;
+                rule->datagram(move(datagram), source.has_value() ? &source.value() : nullptr);
+            }
+        }
+    }
+
+    // 回调中的 write_datagram() 可能取走新的完成，留到下一次
+    vector<IOUring::Completion> completions;
+    completions.swap(_completions);
+    for (const auto &completion : completions) {
+        handle_completion(completion);
+    }
+
+    return Result::Success;
+}
+
+//! \details A single poll request per fd covers the directions its rules are interested in. Changing them
+//! replaces the request; a completion of the old one is then ignored, as it has no Operation any more.
+void EventLoop::update_poll(Registration &reg, const int fd_num, const uint32_t events) {
+    if (reg.poll != 0) {
+        if (reg.events == events) {
+            return;
+        }
+        io_uring_sqe &sqe = _ring->prepare(IORING_OP_POLL_REMOVE, -1, 0);
+        sqe.addr = reg.poll;
+        _operations.erase(reg.poll);
+        reg.poll = 0;
+    }
+
+    reg.events = events;
+    if (events != 0) {
+        const uint64_t user_data = _next_operation++;
+        _operations.emplace(user_data, Operation{Operation::Kind::Poll, fd_num, {}, 0, {}, {}, {}});
+        io_uring_sqe &sqe = _ring->prepare(IORING_OP_POLL_ADD, fd_num, user_data);
+        sqe.poll32_events = events;
+        reg.poll = user_data;
+    }
+}
+
+//! Put a read into the ring for each buffer of the rule that is not in use
+void EventLoop::post_reads(const RuleIter rule) {
+    while (not rule->read_slots.empty()) {
+        const size_t slot = rule->read_slots.back();
+        rule->read_slots.pop_back();
+        char *const buffer = slot_buffer(slot);
+
+        const uint64_t user_data = _next_operation++;
+        Operation &read =
+            _operations.emplace(user_data, Operation{Operation::Kind::Read, rule->fd.fd_num(), rule, slot, {}, {}, {}})
+                .first->second;
+        if (rule->is_socket) {
+            read.iov = {buffer, MAX_DATAGRAM_SIZE};
+            read.message.msg_name = &read.address.storage;
+            read.message.msg_namelen = sizeof(read.address.storage);
+            read.message.msg_iov = &read.iov;
+            read.message.msg_iovlen = 1;
+            io_uring_sqe &sqe = _ring->prepare(IORING_OP_RECVMSG, rule->fd.fd_num(), user_data);
+            sqe.addr = reinterpret_cast<uint64_t>(&read.message);
+            sqe.len = 1;
+            sqe.msg_flags = MSG_TRUNC;
+        } else {
+            io_uring_sqe &sqe = _ring->prepare(
+                _fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ, rule->fd.fd_num(), user_data);
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = MAX_DATAGRAM_SIZE;
+            sqe.off = numeric_limits<uint64_t>::max();  // 当前位置
+            sqe.buf_index = slot;
+        }
+    }
+}
+
+//! \details A rule that is not interested must not take datagrams it cannot deliver, and reads left in the ring
+//! would keep the destructor waiting; the buffers come back to the rule when the reads complete.
+void EventLoop::cancel_reads(const RuleIter rule) {
+    for (const auto &[user_data, operation] : _operations) {
+        if (operation.kind == Operation::Kind::Read and operation.rule == rule) {
+            cancel_operation(user_data);
+        }
+    }
+}
+
+//! Ask the kernel to cancel a request; the request then completes with -ECANCELED (unless it completed already)
+void EventLoop::cancel_operation(const uint64_t user_data) {
+    io_uring_sqe &sqe = _ring->prepare(IORING_OP_ASYNC_CANCEL, -1, 0);
+    sqe.addr = user_data;
+}
+
+//! \details Completed writes are finished here (the buffer is reused at once); the other completions wait in
+//! _completions for wait_io_uring(). Completions without an Operation (cancels, and replaced polls) are dropped.
+void EventLoop::take_completions() {
+    IOUring::Completion completion{};
+    while (_ring->next_completion(completion)) {
+        const auto operation = _operations.find(completion.user_data);
+        if (operation == _operations.end()) {
+            continue;
+        }
+        if (operation->second.kind != Operation::Kind::Write) {
+            _completions.push_back(completion);
+            continue;
+        }
+
+        _free_write_slots.push_back(operation->second.slot);
+        const bool to_socket = operation->second.message.msg_name != nullptr;
+        const size_t size = operation->second.iov.iov_len;
+        _operations.erase(operation);
+        if (completion.result < 0) {
+            throw unix_error(to_socket ? "sendmsg" : "write", -completion.result);
+        }
+        if (size_t(completion.result) != size) {
+            throw runtime_error("EventLoop: datagram was not written whole");
+        }
+    }
+}
+
+void EventLoop::handle_completion(const IOUring::Completion &completion) {
+    const auto found = _operations.find(completion.user_data);
+    if (found == _operations.end()) {
+        return;  // 之后被取消或替换了
+    }
+    const Operation operation = found->second;
+    _operations.erase(found);
+
+    if (operation.kind == Operation::Kind::Poll) {
+        _registrations.at(operation.fd_num).poll = 0;
+        if (completion.result < 0) {
+            throw unix_error("io_uring poll", -completion.result);
+        }
+        const auto revents = static_cast<uint32_t>(completion.result);
+        if (revents & (POLLERR | POLLNVAL)) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // 回调可能添加规则，所以遍历副本
+        for (const RuleIter rule : vector<RuleIter>(_registrations.at(operation.fd_num).rules)) {
+            if (rule->interested and not rule->ring_reads) {
+                handle_ready(rule, revents);
+            }
+        }
+
+        // poll 请求只触发一次：如果 fd 还有规则，重新提交
+        if (_registrations.count(operation.fd_num)) {
+            update_registration(operation.fd_num);
+        }
+        return;
+    }
+
+    // a read: the rule's buffer is free again once the datagram is copied out of it
+    if (not operation.rule.has_value()) {
+        _free_read_slots.push_back(operation.slot);
+        return;
+    }
+    const RuleIter rule = operation.rule.value();
+    if (completion.result < 0) {
+        rule->read_slots.push_back(operation.slot);
+        if (completion.result == -ECANCELED) {
+            // 不感兴趣时取消的读；期间又感兴趣了就重新提交
+            if (rule->interested) {
+                post_reads(rule);
+            }
+            return;
+        }
+        throw unix_error(rule->is_socket ? "recvmsg" : "read", -completion.result);
+    }
+    rule->fd.register_read();
+    if (size_t(completion.result) > MAX_DATAGRAM_SIZE) {
+        throw runtime_error("recvfrom (oversized datagram)");
+    }
+
+    string datagram(slot_buffer(operation.slot), completion.result);
+    rule->read_slots.push_back(operation.slot);
+    if (completion.result == 0 and not rule->is_socket) {
+        rule->fd._internal_fd->_eof = true;
+        cancel_rule(rule);
+        return;
+    }
+
+    optional<Address> source{};
+    if (rule->is_socket and operation.message.msg_namelen > 0) {
+        source.emplace(static_cast<const sockaddr *>(operation.address), operation.message.msg_namelen);
+    }
+    if (rule->interested) {
+        rule->datagram(move(datagram), source.has_value() ? &source.value() : nullptr);
+    } else {
+        rule->pending.emplace_back(move(datagram), move(source));
+        _pending_datagrams++;
+    }
+
+    if (rule->is_defunct()) {
+        cancel_rule(rule);
+    } else if (rule->interested) {
+        post_reads(rule);
+    }
+}
@@ -1,12 +1,26 @@
 #ifndef SPONGE_LIBSPONGE_EVENTLOOP_HH
 #define SPONGE_LIBSPONGE_EVENTLOOP_HH
 
+#include "address.hh"
+#include "buffer.hh"
 #include "file_descriptor.hh"
+#include "io_uring.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,10 +31,27 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How wait_next_event waits for the file descriptors
+    enum class Backend {
+        Poll,   //!< Build the array for [poll(2)](\ref man2::poll) from every Rule on every call
+        Epoll,  //!< Keep the fds registered with [epoll(7)](\ref man7::epoll), updating only interests that changed
+        IOUring,  //!< Batch polls, datagram reads and writes into one [io_uring(7)](\ref man7::io_uring) call per wait
+    };
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered.
+        Timeout,  //!< No rules were triggered before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
 
+    //! Called with each datagram read by a datagram rule, and where it came from (`nullptr` unless fd is a socket)
+    using DatagramCallbackT = std::function<void(std::string &&datagram, const Address *source)>;
+
     //! \brief Specifies a condition and callback that an EventLoop should handle.
     //! \details Created by calling EventLoop::add_rule() or EventLoop::add_cancelable_rule().
     class Rule {
@@ -30,30 +61,148 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool interested;      //!< Backend::Epoll and IOUring: is the rule's direction part of its fd's events?
+
+        //! \name Datagram rules (added with EventLoop::add_datagram_rule)
+        //!@{
+        DatagramCallbackT datagram;  //!< Called with each datagram that the EventLoop reads from fd
+        bool is_socket;              //!< Does each datagram come with a source address?
+        bool ring_reads;             //!< Backend::IOUring: read with requests in the ring, rather than on readiness
+        std::vector<size_t> read_slots;  //!< Backend::IOUring: the rule's read buffers that are not in use
+        //! Backend::IOUring: datagrams read while the rule was not interested, to be delivered first
+        std::deque<std::pair<std::string, std::optional<Address>>> pending;
+        //!@}
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
+
+        //! Should fd be polled? (Rule::interest, or always if there is none)
+        bool is_interested() const { return not interest or interest(); }
+
+        //! Has fd reached EOF (for Direction::In) or been closed, so the rule can never trigger again?
+        bool is_defunct() const { return (direction == Direction::In and fd.eof()) or fd.closed(); }
+    };
+
+    using RuleIter = std::list<Rule>::iterator;
+
+    //! \brief Backend::Epoll: the rules of one file descriptor, and the events it is registered for
+    struct Registration {
+        std::vector<RuleIter> rules{};
+        uint32_t events{0};
+        bool registered{false};    //!< has it been added to the epoll instance?
+        bool always_ready{false};  //!< epoll refused it (e.g. a regular file); like poll, treat it as always ready
+        uint64_t poll{0};          //!< Backend::IOUring: the outstanding poll request for `events`, if any
+    };
+
+    //! \brief Backend::IOUring: a request in the ring
+    struct Operation {
+        enum class Kind { Poll, Read, Write };
+        Kind kind;
+        int fd_num;                     //!< Poll: the fd of the Registration
+        std::optional<RuleIter> rule;   //!< Read: the datagram rule, unless it has been canceled since
+        size_t slot;                    //!< Read, Write: the buffer
+        msghdr message;                 //!< Read, Write on a socket: the header, which carries the address
+        iovec iov;                      //!< Read, Write on a socket: the buffer
+        Address::Raw address;           //!< Read, Write on a socket: the source or destination
     };
 
+    static constexpr size_t MAX_DATAGRAM_SIZE = 65536;  //!< Largest datagram read by a datagram rule
+    static constexpr size_t READ_SLOTS = 16;            //!< Backend::IOUring: buffers for datagram reads
+    static constexpr size_t READS_PER_RULE = 8;         //!< Backend::IOUring: reads kept in the ring per rule
+    static constexpr size_t WRITE_SLOT_SIZE = 2048;     //!< Backend::IOUring: larger datagrams are written at once
+    static constexpr size_t WRITE_SLOTS = 64;           //!< Backend::IOUring: buffers for queued writes
+    static constexpr unsigned RING_ENTRIES = 256;       //!< Backend::IOUring: size of the submission queue
+
+    Backend _backend;
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    //! \name Backend::Epoll state
+    //!@{
+    std::optional<FileDescriptor> _epoll{};
+    std::unordered_map<int, Registration> _registrations{};  //!< by fd number
+    std::vector<RuleIter> _dynamic_rules{};                  //!< rules with an interest callback, asked on every call
+    size_t _interested_rules{0};
+    std::vector<epoll_event> _events{};
+    //!@}
+
+    //! \name Backend::IOUring state
+    //!@{
+    std::optional<IOUring> _ring{};
+    std::vector<char> _buffers{};  //!< READ_SLOTS buffers of MAX_DATAGRAM_SIZE, then WRITE_SLOTS of WRITE_SLOT_SIZE
+    bool _fixed_buffers{false};    //!< were _buffers registered with the kernel?
+    std::vector<size_t> _free_read_slots{};
+    std::vector<size_t> _free_write_slots{};
+    std::unordered_map<uint64_t, Operation> _operations{};  //!< by user_data; 0 is for requests without an answer
+    uint64_t _next_operation{1};
+    std::vector<IOUring::Completion> _completions{};  //!< taken from the ring and not handled yet
+    size_t _pending_datagrams{0};
+    uint64_t _last_write{0};  //!< the last queued write, which the next one to the same fd is linked to
+    int _last_write_fd{-1};
+    //!@}
+
+    std::string _datagram_buffer{};  //!< Reused by read_datagram()
+
+    Result wait_poll(const int timeout_ms);
+    Result wait_epoll(const int timeout_ms);
+    Result wait_io_uring(const int timeout_ms);
+    void add(Rule &&new_rule);
+    void set_interest(const RuleIter rule, const bool interested);
+    void update_interests();
+    void update_registration(const int fd_num);
+    void cancel_rule(const RuleIter rule);
+    void handle_ready(const RuleIter rule, const uint32_t revents);
+    void read_datagram(Rule &rule);
+
+    //! \name Backend::IOUring helpers
+    //!@{
+    char *slot_buffer(const size_t slot);
+    void update_poll(Registration &reg, const int fd_num, const uint32_t events);
+    void post_reads(const RuleIter rule);
+    void cancel_reads(const RuleIter rule);
+    void cancel_operation(const uint64_t user_data);
+    void take_completions();
+    void handle_completion(const IOUring::Completion &completion);
+    //!@}
+
   public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
-    };
+    //! Construct an EventLoop that waits with the given backend
+    //! \note Backend::IOUring falls back to Backend::Epoll if io_uring is unavailable (see backend())
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
+    //! Backend::IOUring: cancel the requests in the ring and wait for them, since they refer to its buffers
+    ~EventLoop();
+
+    //! The backend in use
+    Backend backend() const { return _backend; }
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
+    //! \note Without an `interest` callback, the rule is always interested (and costs Backend::Epoll nothing
+    //! until `fd` is ready).
     void add_rule(const FileDescriptor &fd,
                   const Direction direction,
                   const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
+                  const InterestT &interest = {},
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! \brief Add a rule that reads whole datagrams from `fd` (e.g. a UDP socket or a TUN device), and calls
+    //! `callback` with each one.
+    //! \details Backend::IOUring keeps reads of `fd` in the ring, so several datagrams can arrive per wait.
+    void add_datagram_rule(const FileDescriptor &fd,
+                           const DatagramCallbackT &callback,
+                           const InterestT &interest = {},
+                           const CallbackT &cancel = [] {});
+
+    //! \brief Write `datagram` to `fd`, sending it to `destination` if one is given.
+    //! \details Backend::IOUring copies the datagram into a buffer and submits the write with the next wait (or
+    //! when its buffers run out), so a burst of datagrams costs one system call. Writes queued to the same fd are
+    //! linked, so they complete in order. A datagram larger than a buffer skips the batch: the queued writes are
+    //! submitted, then it is written at once. It can still overtake a queued write that the kernel could not finish
+    //! at once (e.g. one that found the socket buffer full). The other backends write every datagram at once.
+    void write_datagram(FileDescriptor &fd, const BufferViewList &datagram, const Address *destination = nullptr);
+
+    //! Calls [poll(2)](\ref man2::poll), [epoll_wait(2)](\ref man2::epoll_wait) or
+    //! [io_uring_enter(2)](\ref man2::io_uring_enter) and then executes callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
 };
 
@@ -69,6 +218,16 @@ using Direction = EventLoop::Direction;
 //! (for Rule::direction == Direction::In) or writable (for Rule::direction == Direction::Out).
 //! Once this occurs, the Rule is canceled, i.e., the EventLoop deletes it.
 //!
+//! With Backend::Epoll, the file descriptors stay registered with [epoll(7)](\ref man7::epoll) between calls.
+//! Each call asks only the rules that have an Rule::interest callback, changes a registration only when the
+//! answer changes, and visits only the file descriptors that are ready. Rules without an interest callback
+//! cost nothing until their fd is ready.
+//!
+//! With Backend::IOUring, the polls are requests in an [io_uring(7)](\ref man7::io_uring): after a poll
+//! completes, or when interests change, the new requests go to the kernel in the same system call as the
+//! next wait. Datagram rules go further and keep reads in the ring, and write_datagram() queues writes
+//! there, so receiving and sending a burst of datagrams costs one system call in all.
+//!
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
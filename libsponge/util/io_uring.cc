@@ -0,0 +1,162 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+IOUring::Mapping::Mapping(const FileDescriptor &fd, const size_t size, const off_t offset)
+    : _address(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd.fd_num(), offset))
+    , _size(size) {
+    if (_address == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+}
+
+IOUring::Mapping::~Mapping() { ::munmap(_address, _size); }
+
+//! \details Also checks the features that IOUring relies on: one mapping for both rings, and a timeout
+//! passed to [io_uring_enter(2)](\ref man2::io_uring_enter).
+static int setup_ring(const unsigned entries, io_uring_params &params) {
+    const int fd = SystemCall("io_uring_setup", static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params)));
+    constexpr uint32_t needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) {
+        ::close(fd);
+        throw unix_error("io_uring_setup (missing features)", EOPNOTSUPP);
+    }
+    return fd;
+}
+
+//! \returns the size of the mapping that holds both rings
+static size_t rings_size(const io_uring_params &params) {
+    return max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+}
+
+//! \param[in] entries is the size of the submission queue (rounded up to a power of two by the kernel);
+//! the completion queue is twice as large
+IOUring::IOUring(const unsigned entries)
+    : _fd(setup_ring(entries, _params))
+    , _rings(_fd, rings_size(_params), IORING_OFF_SQ_RING)
+    , _sqes(_fd, _params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES) {
+    _sq_head = _rings.at<uint32_t>(_params.sq_off.head);
+    _sq_tail = _rings.at<uint32_t>(_params.sq_off.tail);
+    _sq_mask = *_rings.at<uint32_t>(_params.sq_off.ring_mask);
+    _sq_entries = *_rings.at<uint32_t>(_params.sq_off.ring_entries);
+    _sqe_array = _sqes.at<io_uring_sqe>(0);
+    _prepared_tail = *_sq_tail;
+
+    // 第 i 个提交项总是放在 _sqe_array[i & mask]
+    uint32_t *const sq_array = _rings.at<uint32_t>(_params.sq_off.array);
+    for (uint32_t i = 0; i < _sq_entries; i++) {
+        sq_array[i] = i;
+    }
+
+    _cq_head = _rings.at<uint32_t>(_params.cq_off.head);
+    _cq_tail = _rings.at<uint32_t>(_params.cq_off.tail);
+    _cq_mask = *_rings.at<uint32_t>(_params.cq_off.ring_mask);
+    _cqe_array = _rings.at<io_uring_cqe>(_params.cq_off.cqes);
+}
+
+bool IOUring::available() {
+    static const bool result = [] {
+        try {
+            IOUring ring{1};
+            return true;
+        } catch (const exception &) {
+            // ENOSYS (an old kernel), EPERM (e.g. kernel.io_uring_disabled or seccomp), or missing features
+            return false;
+        }
+    }();
+    return result;
+}
+
+io_uring_sqe &IOUring::prepare(const uint8_t opcode, const int fd, const uint64_t user_data) {
+    if (_prepared_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries) {
+        submit();
+        if (_prepared_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries) {
+            throw runtime_error("IOUring: the kernel did not take the submission queue");
+        }
+    }
+
+    io_uring_sqe &sqe = _sqe_array[_prepared_tail & _sq_mask];
+    _prepared_tail++;
+    sqe = io_uring_sqe{};
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.user_data = user_data;
+    return sqe;
+}
+
+bool IOUring::link_last(const uint64_t user_data) {
+    // 队列满时下一个请求会先触发 submit()，链接会断在两次提交之间
+    if (prepared() == 0 or _prepared_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries) {
+        return false;
+    }
+    io_uring_sqe &sqe = _sqe_array[(_prepared_tail - 1) & _sq_mask];
+    if (sqe.user_data != user_data) {
+        return false;
+    }
+    sqe.flags |= IOSQE_IO_LINK;
+    return true;
+}
+
+//! \param[in] wait is whether to wait for a completion (returns at once if there already is one)
+//! \param[in] timeout_ms is the longest wait, in milliseconds; negative to wait forever
+bool IOUring::submit(const bool wait, const int timeout_ms) {
+    // 内核只读取 tail 之前的提交项
+    __atomic_store_n(_sq_tail, _prepared_tail, __ATOMIC_RELEASE);
+    const uint32_t to_submit = _prepared_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (to_submit == 0 and not wait) {
+        return true;
+    }
+
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    unsigned flags = 0;
+    if (wait) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeout_ms >= 0) {
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+
+    const int ret = static_cast<int>(::syscall(__NR_io_uring_enter,
+                                               _fd.fd_num(),
+                                               to_submit,
+                                               wait ? 1 : 0,
+                                               flags,
+                                               wait ? &arg : nullptr,
+                                               wait ? sizeof(arg) : 0));
+    const bool interrupted = ret < 0 and errno == EINTR;
+    // ETIME: the wait timed out; EBUSY: the completion queue has to be emptied before more requests are taken
+    const int tolerated = ret < 0 and (errno == ETIME or errno == EBUSY or interrupted) ? errno : 0;
+    SystemCall("io_uring_enter", ret, tolerated);
+    return not interrupted;
+}
+
+bool IOUring::next_completion(Completion &completion) {
+    const uint32_t head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const io_uring_cqe &cqe = _cqe_array[head & _cq_mask];
+    completion = {cqe.user_data, cqe.res};
+    __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void IOUring::register_buffers(const vector<iovec> &buffers) {
+    SystemCall("io_uring_register",
+               static_cast<int>(::syscall(
+                   __NR_io_uring_register, _fd.fd_num(), IORING_REGISTER_BUFFERS, buffers.data(), buffers.size())));
+}
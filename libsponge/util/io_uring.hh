@@ -0,0 +1,122 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+//! \brief An [io_uring(7)](\ref man7::io_uring) instance: a submission queue and a completion queue shared
+//! with the kernel
+//!
+//! Requests are prepared in the submission queue with prepare(), and handed to the kernel in one batch by
+//! submit(), which can also wait for the first completion. Completions are then taken from the completion
+//! queue with next_completion(). The rings are set up with the system calls themselves (no liburing).
+class IOUring {
+  public:
+    //! \brief The outcome of a request
+    struct Completion {
+        uint64_t user_data;  //!< as given to prepare()
+        int32_t result;      //!< the result of the request, or a negated errno
+    };
+
+  private:
+    //! \brief Memory shared with the kernel, unmapped on destruction
+    class Mapping {
+        void *_address;
+        size_t _size;
+
+      public:
+        //! Map `size` bytes of the ring `fd` at `offset` (one of the IORING_OFF_* constants)
+        Mapping(const FileDescriptor &fd, const size_t size, const off_t offset);
+        ~Mapping();
+
+        //! \returns the object at `offset` bytes into the mapping
+        template <typename T>
+        T *at(const uint32_t offset) const {
+            return reinterpret_cast<T *>(static_cast<char *>(_address) + offset);
+        }
+
+        //! \name
+        //! A Mapping cannot be copied or moved
+
+        //!@{
+        Mapping(const Mapping &other) = delete;
+        Mapping &operator=(const Mapping &other) = delete;
+        Mapping(Mapping &&other) = delete;
+        Mapping &operator=(Mapping &&other) = delete;
+        //!@}
+    };
+
+    io_uring_params _params{};
+    FileDescriptor _fd;
+    Mapping _rings;  //!< both rings (IORING_FEAT_SINGLE_MMAP)
+    Mapping _sqes;   //!< the submission queue entries
+
+    //! \name Submission queue
+    //!@{
+    uint32_t *_sq_head{nullptr};  //!< advanced by the kernel as it consumes entries
+    uint32_t *_sq_tail{nullptr};  //!< published by submit()
+    uint32_t _sq_mask{0};
+    uint32_t _sq_entries{0};
+    io_uring_sqe *_sqe_array{nullptr};
+    uint32_t _prepared_tail{0};  //!< entries up to here have been prepared
+    //!@}
+
+    //! \name Completion queue
+    //!@{
+    uint32_t *_cq_head{nullptr};  //!< advanced by next_completion()
+    uint32_t *_cq_tail{nullptr};  //!< advanced by the kernel as requests complete
+    uint32_t _cq_mask{0};
+    io_uring_cqe *_cqe_array{nullptr};
+    //!@}
+
+  public:
+    //! \brief Set up a ring with room for `entries` requests in the submission queue
+    //! \throws unix_error if the kernel does not support io_uring (or forbids it), or lacks a needed feature
+    explicit IOUring(const unsigned entries);
+
+    //! \returns `true` if io_uring can be used here (checked once)
+    static bool available();
+
+    //! \brief Add a request to the submission queue, submitting the queue first if it is full
+    //! \returns the entry, zeroed except for `opcode`, `fd` and `user_data`, for the caller to fill in
+    io_uring_sqe &prepare(const uint8_t opcode, const int fd, const uint64_t user_data);
+
+    //! \brief Make the next request start only after the request `user_data` completes (IOSQE_IO_LINK)
+    //! \details Only if `user_data` is the last request prepared and the next one will go in the same submit().
+    //! \returns `false`, changing nothing, otherwise
+    bool link_last(const uint64_t user_data);
+
+    //! \brief Hand the prepared requests to the kernel, in one system call
+    //! \details With `wait`, also waits up to `timeout_ms` (forever if negative) for a completion.
+    //! \returns `false` if the wait was interrupted by a signal
+    bool submit(const bool wait = false, const int timeout_ms = -1);
+
+    //! \brief Take the next completion from the completion queue
+    //! \returns `false` if there is none
+    bool next_completion(Completion &completion);
+
+    //! \brief Register `buffers` with the kernel for IORING_OP_READ_FIXED and IORING_OP_WRITE_FIXED
+    //! \details A request names a buffer by its index in `buffers`.
+    void register_buffers(const std::vector<iovec> &buffers);
+
+    //! \returns the number of prepared requests that have not been submitted
+    uint32_t prepared() const { return _prepared_tail - *_sq_tail; }
+
+    //! \name
+    //! An IOUring cannot be copied or moved
+
+    //!@{
+    IOUring(const IOUring &other) = delete;
+    IOUring &operator=(const IOUring &other) = delete;
+    IOUring(IOUring &&other) = delete;
+    IOUring &operator=(IOUring &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
@@ -74,6 +74,17 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    template <typename T>
+    static void _unparse_int(char *&out, T val);
+
+    //! \name Write into a preallocated buffer
+    //! Write an integer in network byte order at `out`, and advance `out` past it
+    //!@{
+    static void u32(char *&out, const uint32_t val);
+    static void u16(char *&out, const uint16_t val);
+    static void u8(char *&out, const uint8_t val);
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
@@ -166,3 +166,9 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+// the kernel caps the sizes at net.core.wmem_max and net.core.rmem_max
+void Socket::set_buffer_sizes(const int size) {
+    setsockopt(SOL_SOCKET, SO_SNDBUF, size);
+    setsockopt(SOL_SOCKET, SO_RCVBUF, size);
+}
@@ -45,6 +45,9 @@ class Socket : public FileDescriptor {
 
     //! Allow local address to be reused sooner via [SO_REUSEADDR](\ref man7::socket)
     void set_reuseaddr();
+
+    //! Request kernel send and receive buffers of `size` bytes via [SO_SNDBUF and SO_RCVBUF](\ref man7::socket)
+    void set_buffer_sizes(const int size);
 };
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
@@ -0,0 +1,127 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+//! \param[in] deadline the time at which the timer expires, in milliseconds
+//! \param[in] callback the function to call when it does
+TimerWheel::TimerId TimerWheel::add(const uint64_t deadline, const CallbackT &callback) {
+    const TimerId id = _next_id++;
+    Timer &timer = _timers.emplace(id, Timer{max(deadline, _now + 1), callback, 0, 0}).first->second;
+    insert(id, timer);
+    return id;
+}
+
+void TimerWheel::cancel(const TimerId id) {
+    const auto it = _timers.find(id);
+    if (it == _timers.end()) {
+        return;
+    }
+    // 正在过期的 timer 已经不在 slot 中了
+    auto &slot = _wheels[it->second.level][it->second.slot];
+    const auto entry = find(slot.begin(), slot.end(), id);
+    if (entry != slot.end()) {
+        *entry = slot.back();
+        slot.pop_back();
+        _level_size[it->second.level]--;
+    }
+    _timers.erase(it);
+}
+
+//! \details A timer goes to the lowest level whose slots, counted from the current one, reach its deadline.
+//! Deadlines beyond SPAN are filed at the far end of the top level, and re-filed when it cascades.
+void TimerWheel::insert(const TimerId id, Timer &timer) {
+    uint64_t slot_time = max(timer.deadline, _now);
+    if (slot_time - _now >= SPAN) {
+        slot_time = _now + SPAN - 1;
+    }
+    const uint64_t delta = slot_time - _now;
+    size_t level = 0;
+    while (delta >> (LEVEL_BITS * (level + 1))) {
+        level++;
+    }
+    timer.level = level;
+    timer.slot = (slot_time >> (LEVEL_BITS * level)) & (SLOTS - 1);
+    _wheels[level][timer.slot].push_back(id);
+    _level_size[level]++;
+}
+
+//! Re-file the timers of the current slot of `level` into the lower levels
+void TimerWheel::cascade(const size_t level) {
+    auto &slot = _wheels[level][(_now >> (LEVEL_BITS * level)) & (SLOTS - 1)];
+    if (slot.empty()) {
+        return;
+    }
+    vector<TimerId> ids;
+    ids.swap(slot);
+    _level_size[level] -= ids.size();
+    for (const TimerId id : ids) {
+        insert(id, _timers.at(id));
+    }
+}
+
+//! Call the callbacks of the timers whose deadline is exactly `_now`
+void TimerWheel::expire_current_slot() {
+    auto &slot = _wheels[0][_now & (SLOTS - 1)];
+    if (slot.empty()) {
+        return;
+    }
+    vector<TimerId> ids;
+    ids.swap(slot);
+    _level_size[0] -= ids.size();
+    for (const TimerId id : ids) {
+        // 可能已经被前面的 callback 取消
+        const auto it = _timers.find(id);
+        if (it == _timers.end()) {
+            continue;
+        }
+        const CallbackT callback = move(it->second.callback);
+        _timers.erase(it);
+        callback();
+    }
+}
+
+//! \param[in] now the current time, in milliseconds
+void TimerWheel::advance(const uint64_t now) {
+    while (_now < now) {
+        if (_timers.empty()) {
+            _now = now;
+            return;
+        }
+        // 较低的层都是空的：直接跳到最低非空层的下一个 slot
+        size_t lowest = 0;
+        while (_level_size[lowest] == 0) {
+            lowest++;
+        }
+        const uint64_t step_mask = (uint64_t{1} << (LEVEL_BITS * lowest)) - 1;
+        _now = min(now, (_now | step_mask) + 1);
+
+        for (size_t level = LEVELS - 1; level > 0; level--) {
+            if ((_now & ((uint64_t{1} << (LEVEL_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        expire_current_slot();
+    }
+}
+
+std::optional<uint64_t> TimerWheel::next_expiry() const {
+    optional<uint64_t> earliest{};
+    for (size_t level = 0; level < LEVELS; level++) {
+        if (_level_size[level] == 0) {
+            continue;
+        }
+        const size_t shift = LEVEL_BITS * level;
+        const uint64_t current = _now >> shift;
+        for (uint64_t k = 1; k <= SLOTS; k++) {
+            if (!_wheels[level][(current + k) & (SLOTS - 1)].empty()) {
+                // 第 0 层的 slot 只有一个 deadline；更高层取 slot 的起点
+                const uint64_t start = (current + k) << shift;
+                earliest = min(earliest.value_or(start), start);
+                break;
+            }
+        }
+    }
+    return earliest;
+}
@@ -0,0 +1,77 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A hierarchical timer wheel with a granularity of one millisecond
+//!
+//! Timers are kept in LEVELS wheels of SLOTS slots each. A slot of level `l` covers `SLOTS^l`
+//! milliseconds, so adding and cancelling a timer cost O(1) however many timers there are, and
+//! advance() only looks at the slots whose time has come. When the time reaches a slot of a
+//! higher level, its timers are spread over the lower levels ("cascading").
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;                     //!< Identifies a timer that has been added
+    using CallbackT = std::function<void(void)>;  //!< Called when a timer expires
+
+    static constexpr size_t LEVEL_BITS = 6;                          //!< log2 of the number of slots per level
+    static constexpr size_t SLOTS = 1 << LEVEL_BITS;                 //!< Number of slots per level
+    static constexpr size_t LEVELS = 4;                              //!< Number of levels
+    static constexpr uint64_t SPAN = 1ULL << (LEVEL_BITS * LEVELS);  //!< Time covered by all levels (~4.6 hours)
+
+  private:
+    //! \brief A timer that has been added and has neither expired nor been cancelled
+    struct Timer {
+        uint64_t deadline;
+        CallbackT callback;
+        size_t level;  //!< the slot that holds its id
+        size_t slot;
+    };
+
+    uint64_t _now;  //!< every timer with a deadline up to `_now` has expired
+    TimerId _next_id{0};
+    std::array<std::array<std::vector<TimerId>, SLOTS>, LEVELS> _wheels{};
+    std::array<size_t, LEVELS> _level_size{};  //!< number of timers in each level
+    std::unordered_map<TimerId, Timer> _timers{};
+
+    void insert(const TimerId id, Timer &timer);
+    void cascade(const size_t level);
+    void expire_current_slot();
+
+  public:
+    //! \brief Construct a wheel whose time starts at `now` (in milliseconds)
+    explicit TimerWheel(const uint64_t now = 0) : _now(now) {}
+
+    //! \brief Call `callback` once the time reaches `deadline` (in milliseconds)
+    //! \note A deadline that has already passed expires at the next millisecond
+    TimerId add(const uint64_t deadline, const CallbackT &callback);
+
+    //! \brief Forget a timer; does nothing if it already expired or was cancelled
+    void cancel(const TimerId id);
+
+    //! \brief Move the time forward to `now`, calling the callback of every timer that expires, earliest first
+    //! \details Callbacks may add and cancel timers.
+    void advance(const uint64_t now);
+
+    //! \name Accessors
+    //!@{
+
+    //! \returns a time no later than the earliest deadline (exact if it is less than SLOTS ms away),
+    //! or nothing if there are no timers
+    std::optional<uint64_t> next_expiry() const;
+
+    //! \returns the time up to which timers have expired
+    uint64_t now() const { return _now; }
+
+    //! \returns the number of pending timers
+    size_t size() const { return _timers.size(); }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -45,6 +45,9 @@ int SystemCall(const char *attempt, const int return_value, const int errno_mask
 //! Version of SystemCall that takes a C++ std::string
 int SystemCall(const std::string &attempt, const int return_value, const int errno_mask = 0);
 
+//! Number of system calls made through SystemCall so far, by all threads
+uint64_t system_call_count();
+
 //! Seed a fast random generator
 std::mt19937 get_random_generator();
 
@@ -54,12 +57,14 @@ uint64_t timestamp_ms();
 //! The internet checksum algorithm
 class InternetChecksum {
   private:
-    uint32_t _sum;
-    bool _parity{};
+    uint64_t _sum;   //!< Sum of the 16-bit words so far (in network byte order), not yet folded
+    bool _parity{};  //!< Did the data so far have an odd length?
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
+    //! The sum so far, folded into 16 bits; it can be the `initial_sum` of another InternetChecksum
+    uint16_t sum() const;
     uint16_t value() const;
 };
 
@@ -0,0 +1,108 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"ring: write-pop-end", 15, ByteStream::Backend::Ring};
+
+            test.execute(Write{"cat"});
+            test.execute(Peek{"cat"});
+            test.execute(Pop{3});
+            test.execute(EndInput{});
+
+            test.execute(InputEnded{true});
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+            test.execute(BytesRead{3});
+            test.execute(BytesWritten{3});
+            test.execute(RemainingCapacity{15});
+        }
+
+        {
+            ByteStreamTestHarness test{"ring: overwrite", 2, ByteStream::Backend::Ring};
+
+            test.execute(Write{"cat"}.with_bytes_written(2));
+            test.execute(Write{"t"}.with_bytes_written(0));
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"ca"});
+            test.execute(Pop{1});
+            test.execute(Write{"tac"}.with_bytes_written(1));
+            test.execute(Peek{"at"});
+        }
+
+        {
+            ByteStreamTestHarness test{"ring: wraparound", 5, ByteStream::Backend::Ring};
+
+            test.execute(Write{"abcd"}.with_bytes_written(4));
+            test.execute(Pop{3});
+            test.execute(Write{"efgh"}.with_bytes_written(4));
+            test.execute(BufferSize{5});
+            test.execute(Peek{"defgh"});
+            test.execute(Pop{2});
+            test.execute(Peek{"fgh"});
+            test.execute(Write{"ij"}.with_bytes_written(2));
+            test.execute(Peek{"fghij"});
+            test.execute(Pop{5});
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{10});
+            test.execute(BytesWritten{10});
+        }
+
+        {
+            ByteStreamTestHarness test{"ring: zero capacity", 0, ByteStream::Backend::Ring};
+
+            test.execute(Write{"cat"}.with_bytes_written(0));
+            test.execute(Pop{0});
+            test.execute(Peek{""});
+            test.execute(EndInput{});
+            test.execute(Eof{true});
+        }
+
+        {
+            auto rd = get_random_generator();
+            const size_t CAPACITY = 997;
+            ByteStreamTestHarness ring{"ring: random", CAPACITY, ByteStream::Backend::Ring};
+            ByteStreamTestHarness list{"buffer list: random", CAPACITY};
+
+            string expected;
+            size_t written = 0;
+            size_t read = 0;
+            for (size_t i = 0; i < 2000; ++i) {
+                const size_t room = CAPACITY - expected.size();
+                const size_t size = rd() % (room + 1);
+                string d(size, 0);
+                generate(d.begin(), d.end(), [&] { return 'a' + (rd() % 26); });
+                ring.execute(Write{d}.with_bytes_written(size));
+                list.execute(Write{d}.with_bytes_written(size));
+                expected += d;
+                written += size;
+
+                const size_t to_pop = rd() % (expected.size() + 1);
+                ring.execute(Peek{expected.substr(0, to_pop)});
+                list.execute(Peek{expected.substr(0, to_pop)});
+                ring.execute(Pop{to_pop});
+                list.execute(Pop{to_pop});
+                expected.erase(0, to_pop);
+                read += to_pop;
+
+                ring.execute(BufferSize{expected.size()});
+                ring.execute(BytesWritten{written});
+                ring.execute(BytesRead{read});
+            }
+        }
+
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
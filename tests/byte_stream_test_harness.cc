@@ -45,11 +45,14 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Backend backend)
+    : _test_name(test_name), _byte_stream(capacity, backend) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", backend=" << (backend == ByteStream::Backend::Ring ? "ring" : "buffer list")
+       << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -181,4 +184,9 @@ void Peek::execute(ByteStream &bs) const {
         throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
                                              output + "\"");
     }
+    const auto buffers = bs.peek_buffers(_output.size()).concatenate();
+    if (buffers != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" from peek_buffers(), but found \"" +
+                                             buffers + "\"");
+    }
 }
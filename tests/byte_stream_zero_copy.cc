@@ -0,0 +1,105 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error("zero-copy check failed: " + what);
+    }
+}
+
+int main() {
+    try {
+        {
+            // a fully accepted rvalue write adopts the caller's allocation
+            ByteStream bs{64};
+            string data(40, 'x');
+            const char *storage = data.data();
+            check(bs.write(move(data)) == 40, "rvalue write accepted 40 bytes");
+            const BufferList out = bs.peek_buffers(40);
+            check(out.buffers().size() == 1, "one Buffer for one write");
+            check(out.buffers().front().str().data() == storage, "rvalue write shares the caller's storage");
+        }
+
+        {
+            // a partial rvalue write keeps only the prefix that fits
+            ByteStream bs{10};
+            check(bs.write(string("abcdefghijklmnop")) == 10, "partial rvalue write accepted 10 bytes");
+            check(bs.peek_output(10) == "abcdefghij", "partial rvalue write contents");
+            check(bs.remaining_capacity() == 0, "partial rvalue write filled the stream");
+        }
+
+        {
+            // Buffer writes share storage, even when only a prefix fits
+            ByteStream bs{6};
+            const Buffer data{string("catdog!")};
+            check(bs.write(data) == 6, "Buffer write accepted 6 bytes");
+            const BufferList out = bs.read_buffers(4);
+            check(out.buffers().size() == 1 and out.buffers().front().str() == "catd", "read_buffers contents");
+            check(out.buffers().front().str().data() == data.str().data(), "Buffer write shares storage");
+            check(bs.peek_output(10) == "og", "remaining bytes after read_buffers");
+            check(bs.bytes_read() == 4, "read_buffers pops the bytes");
+        }
+
+        {
+            // read_buffers spans several writes and trims the last one
+            ByteStream bs{100};
+            bs.write(string("hello, "));
+            bs.write(string("world"));
+            bs.write(string("!!!"));
+            const BufferList out = bs.read_buffers(10);
+            check(out.buffers().size() == 2, "read_buffers returns one slice per write touched");
+            check(out.concatenate() == "hello, wor", "read_buffers contents across writes");
+            check(bs.read(10) == "ld!!!", "remaining bytes after read_buffers across writes");
+            check(bs.buffer_empty(), "stream drained");
+        }
+
+        {
+            // read_buffer shares storage within one write, and copies only across writes
+            ByteStream bs{100};
+            const Buffer first{string("hello, ")};
+            bs.write(first);
+            bs.write(string("world"));
+            const Buffer head = bs.read_buffer(5);
+            check(head.str() == "hello" and head.str().data() == first.str().data(), "read_buffer shares storage");
+            check(bs.read_buffer(4).str() == ", wo", "read_buffer contents across writes");
+            check(bs.read_buffer(10).str() == "rld", "read_buffer stops at the end of the buffer");
+            check(bs.read_buffer(10).size() == 0 and bs.bytes_read() == 12, "read_buffer on an empty stream");
+        }
+
+        {
+            // the ring backend copies, but gives the same results
+            ByteStream bs{8, ByteStream::Backend::Ring};
+            check(bs.write(string("0123456789")) == 8, "ring rvalue write accepted 8 bytes");
+            bs.pop_output(6);
+            check(bs.write(Buffer{string("abcdef")}) == 6, "ring Buffer write accepted 6 bytes");
+            check(bs.read_buffers(8).concatenate() == "67abcdef", "ring read_buffers contents");
+            check(bs.write(string("xyz")) == 3 and bs.read_buffer(2).str() == "xy", "ring read_buffer contents");
+        }
+
+        {
+            // in-order Buffers pushed into a StreamReassembler go straight to the stream
+            StreamReassembler reassembler{8};
+            const Buffer first{string("abcd")}, second{string("efghij")};
+            reassembler.push_substring(first, 0, false);
+            reassembler.push_substring(second, 4, true);
+            const BufferList out = reassembler.stream_out().peek_buffers(8);
+            check(out.buffers().size() == 2, "one Buffer per in-order push");
+            check(out.buffers().front().str().data() == first.str().data(), "in-order push shares storage");
+            check(out.buffers().back().str().data() == second.str().data(), "in-order push beyond capacity is trimmed");
+            check(out.concatenate() == "abcdefgh", "in-order push contents");
+            check(not reassembler.stream_out().input_ended(), "truncated last segment does not end the stream");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
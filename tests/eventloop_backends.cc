@@ -0,0 +1,219 @@
+#include "address.hh"
+#include "eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+void check(const bool condition, const string &expected, const int lineno) {
+    if (not condition) {
+        throw runtime_error("expected " + expected + " (at line " + to_string(lineno) + ")");
+    }
+}
+
+pair<LocalStreamSocket, LocalStreamSocket> make_pair_of_sockets() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {LocalStreamSocket{FileDescriptor{fds[0]}}, LocalStreamSocket{FileDescriptor{fds[1]}}};
+}
+
+void check_backend(const EventLoop::Backend backend) {
+    // 无 interest 的规则一直被监听；有 interest 的规则只在它返回 true 时
+    {
+        EventLoop eventloop{backend};
+        auto ab = make_pair_of_sockets();
+        auto &a = ab.first;
+        auto &b = ab.second;
+        auto cd = make_pair_of_sockets();
+        auto &c = cd.first;
+        auto &d = cd.second;
+        string from_a, from_c;
+        bool want_c = false;
+        eventloop.add_rule(a, Direction::In, [&] { from_a += a.read(); });
+        eventloop.add_rule(
+            c, Direction::In, [&] { from_c += c.read(); }, [&] { return want_c; });
+
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Timeout, "Timeout", __LINE__);
+        b.write("hello");
+        d.write("world");
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Success, "Success", __LINE__);
+        check(from_a == "hello", "from_a == \"hello\"", __LINE__);
+        check(from_c == "", "from_c == \"\"", __LINE__);
+
+        want_c = true;
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Success, "Success", __LINE__);
+        check(from_c == "world", "from_c == \"world\"", __LINE__);
+
+        // 一个 fd 上的两个方向
+        bool wrote = false;
+        eventloop.add_rule(
+            a, Direction::Out, [&] { wrote = true; }, [&] { return not wrote; });
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Success, "Success", __LINE__);
+        check(wrote, "wrote", __LINE__);
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Timeout, "Timeout", __LINE__);
+        b.write("again");
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Success, "Success", __LINE__);
+        check(from_a == "helloagain", "from_a == \"helloagain\"", __LINE__);
+    }
+
+    // EOF 取消规则并调用 cancel；没有规则时返回 Exit
+    {
+        EventLoop eventloop{backend};
+        auto ab = make_pair_of_sockets();
+        auto &a = ab.first;
+        auto &b = ab.second;
+        bool cancelled = false;
+        eventloop.add_rule(
+            a, Direction::In, [&] { a.read(); }, {}, [&] { cancelled = true; });
+        b.close();
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Success, "Success", __LINE__);
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+        check(cancelled, "cancelled", __LINE__);
+    }
+
+    // 没有 interested 的规则时返回 Exit
+    {
+        EventLoop eventloop{backend};
+        auto ab = make_pair_of_sockets();
+        auto &a = ab.first;
+        eventloop.add_rule(
+            a, Direction::In, [&] { a.read(); }, [] { return false; });
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+    }
+
+    // 数据报规则：每个数据报整体交给回调，连同来源地址
+    {
+        EventLoop eventloop{backend};
+        UDPSocket a, b;
+        a.bind(Address("127.0.0.1", 0));
+        b.bind(Address("127.0.0.1", 0));
+        const Address to_a = a.local_address(), to_b = b.local_address();
+        vector<string> received;
+        string source;
+        bool want = true;
+        eventloop.add_datagram_rule(
+            a,
+            [&](string &&datagram, const Address *from) {
+                received.push_back(move(datagram));
+                source = from ? from->to_string() : "";
+            },
+            [&] { return want; });
+
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Timeout, "Timeout", __LINE__);
+        eventloop.write_datagram(b, string("first"), &to_a);
+        eventloop.write_datagram(b, string("second"), &to_a);
+        for (int i = 0; i < 10 and received.size() < 2; i++) {
+            check(eventloop.wait_next_event(1000) == EventLoop::Result::Success, "Success", __LINE__);
+        }
+        check(received == vector<string>{"first", "second"}, "two datagrams in order", __LINE__);
+        check(source == to_b.to_string(), "source == b", __LINE__);
+
+        // 不感兴趣时收到的数据报在重新感兴趣后交付
+        want = false;
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+        eventloop.write_datagram(b, string("third"), &to_a);
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+        want = true;
+        for (int i = 0; i < 10 and received.size() < 3; i++) {
+            check(eventloop.wait_next_event(1000) == EventLoop::Result::Success, "Success", __LINE__);
+        }
+        check(received.size() == 3 and received.back() == "third", "third datagram", __LINE__);
+    }
+
+    // 超过写缓冲区大小的数据报直接写出，但不会越过之前排队的数据报
+    {
+        EventLoop eventloop{backend};
+        UDPSocket a, b;
+        a.bind(Address("127.0.0.1", 0));
+        const Address to_a = a.local_address();
+        vector<string> received;
+        eventloop.add_datagram_rule(a, [&](string &&datagram, const Address *) { received.push_back(move(datagram)); });
+        eventloop.write_datagram(b, string("small"), &to_a);
+        eventloop.write_datagram(b, string(3000, 'x'), &to_a);
+        eventloop.write_datagram(b, string("last"), &to_a);
+        for (int i = 0; i < 10 and received.size() < 3; i++) {
+            check(eventloop.wait_next_event(1000) == EventLoop::Result::Success, "Success", __LINE__);
+        }
+        check(received == vector<string>{"small", string(3000, 'x'), "last"}, "three datagrams in order", __LINE__);
+    }
+
+    // 读已经提交之后规则失去兴趣，再到达的数据报不会让析构函数永远等待已经取出的完成
+    {
+        UDPSocket a, b;
+        a.bind(Address("127.0.0.1", 0));
+        const Address to_a = a.local_address();
+        bool want = true;
+        size_t received = 0;
+        auto eventloop = make_unique<EventLoop>(backend);
+        eventloop->add_datagram_rule(
+            a, [&](string &&, const Address *) { received++; }, [&] { return want; });
+        check(eventloop->wait_next_event(0) == EventLoop::Result::Timeout, "Timeout", __LINE__);
+        want = false;
+        b.sendto(to_a, string("late"));
+        this_thread::sleep_for(chrono::milliseconds(10));
+        check(eventloop->wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+        alarm(5);  // 析构函数卡住时由 SIGALRM 结束测试
+        eventloop.reset();
+        alarm(0);
+        check(received == 0, "no datagram delivered while uninterested", __LINE__);
+    }
+
+    // 非 socket 的数据报 fd（像 TUN 设备一样保留边界的 pipe）：没有来源地址，EOF 取消规则
+    {
+        EventLoop eventloop{backend};
+        int fds[2];
+        SystemCall("pipe2", ::pipe2(static_cast<int *>(fds), O_DIRECT));
+        FileDescriptor a{fds[0]}, b{fds[1]};
+        vector<string> received;
+        bool had_source = false, cancelled = false;
+        eventloop.add_datagram_rule(
+            a,
+            [&](string &&datagram, const Address *from) {
+                received.push_back(move(datagram));
+                had_source |= from != nullptr;
+            },
+            {},
+            [&] { cancelled = true; });
+        eventloop.write_datagram(b, string("one"));
+        eventloop.write_datagram(b, string("two"));
+        for (int i = 0; i < 10 and received.size() < 2; i++) {
+            check(eventloop.wait_next_event(1000) == EventLoop::Result::Success, "Success", __LINE__);
+        }
+        check(received == vector<string>{"one", "two"}, "two datagrams in order", __LINE__);
+        b.close();
+        for (int i = 0; i < 10 and not cancelled; i++) {
+            eventloop.wait_next_event(1000);
+        }
+        check(cancelled, "cancelled", __LINE__);
+        check(not had_source, "no source address", __LINE__);
+        check(eventloop.wait_next_event(0) == EventLoop::Result::Exit, "Exit", __LINE__);
+    }
+}
+
+int main() {
+    try {
+        check_backend(EventLoop::Backend::Poll);
+        check_backend(EventLoop::Backend::Epoll);
+        // 没有 io_uring 时退回 Backend::Epoll
+        check_backend(EventLoop::Backend::IOUring);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+
+        const auto send_data = [](TCPTestHarness &test, const WrappingInt32 seqno, const WrappingInt32 ackno) {
+            SendSegment seg{};
+            seg.with_ack(true).with_ackno(ackno).with_win(5000).with_seqno(seqno).with_data(string(1000, 'x'));
+            test.execute(seg);
+        };
+
+        // test #1: every second in-order segment is ACKed
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            for (unsigned int i = 0; i < 4; i += 2) {
+                send_data(test_1, rx_isn + 1 + 1000 * i, tx_isn + 1);
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: the first segment should not be ACKed at once");
+                send_data(test_1, rx_isn + 1 + 1000 * (i + 1), tx_isn + 1);
+                test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + 1000 * (i + 2)),
+                               "test 1 failed: the second segment should be ACKed");
+            }
+        }
+
+        // test #2: a lone segment is ACKed when the delayed-ACK timer expires
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            send_data(test_2, rx_isn + 1, tx_isn + 1);
+            test_2.execute(Tick(cfg.ack_delay - 1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ACK sent before the delayed-ACK timer expired");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1001),
+                           "test 2 failed: no ACK when the delayed-ACK timer expired");
+            test_2.execute(Tick(10 * cfg.ack_delay));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: the delayed ACK was sent twice");
+        }
+
+        // test #3: out-of-order data, and the data filling the gap, are ACKed at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            send_data(test_3, rx_isn + 1001, tx_isn + 1);
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1),
+                           "test 3 failed: out-of-order data should be ACKed at once");
+            send_data(test_3, rx_isn + 1, tx_isn + 1);
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2001),
+                           "test 3 failed: data filling a gap should be ACKed at once");
+        }
+
+        // test #4: a FIN is ACKed at once, and its ACK covers the delayed one
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            send_data(test_4, rx_isn + 1, tx_isn + 1);
+            test_4.execute(ExpectNoSegment{});
+            test_4.send_fin(rx_isn + 1001, tx_isn + 1);
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1002),
+                           "test 4 failed: FIN should be ACKed at once");
+            test_4.execute(ExpectState{State::CLOSE_WAIT});
+            test_4.execute(Tick(10 * cfg.ack_delay));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: the delayed ACK was sent after the FIN's ACK");
+        }
+
+        // test #5: outgoing data carries the delayed ACK
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            send_data(test_5, rx_isn + 1, tx_isn + 1);
+            test_5.execute(ExpectNoSegment{});
+            test_5.execute(Write{"hello"});
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1001).with_data("hello"));
+            test_5.execute(Tick(10 * cfg.ack_delay));
+            test_5.execute(ExpectNoSegment{}, "test 5 failed: the delayed ACK was sent after data carried it");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const TCPConfig cfg{};
+
+        // test #1: in-order data is predicted; out-of-order data and the data filling the gap are not
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_1.execute(ExpectPredictedSegments{0});
+
+            test_1.send_byte(rx_isn + 1, tx_isn + 1, 'a');
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_1.execute(ExpectData{}.with_data("a"));
+            test_1.execute(ExpectPredictedSegments{1}, "test 1 failed: in-order data should be predicted");
+
+            test_1.send_byte(rx_isn + 3, tx_isn + 1, 'c');
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_1.send_byte(rx_isn + 2, tx_isn + 1, 'b');
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4));
+            test_1.execute(ExpectData{}.with_data("bc"));
+            test_1.execute(ExpectPredictedSegments{1}, "test 1 failed: reordered data should take the general path");
+
+            test_1.send_byte(rx_isn + 4, tx_isn + 1, 'd');
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 5));
+            test_1.execute(ExpectData{}.with_data("d"));
+            test_1.execute(ExpectPredictedSegments{2});
+            test_1.execute(ExpectState{State::ESTABLISHED});
+        }
+
+        // test #2: an ACK of new data is predicted, even if it moves the window; a duplicate ACK, a window update
+        // or data that moves the window are not
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_2.execute(Write{"hello"});
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 1).with_data("hello"));
+            test_2.send_ack(rx_isn + 1, tx_isn + 6);
+            test_2.execute(ExpectBytesInFlight{0});
+            test_2.execute(ExpectPredictedSegments{1}, "test 2 failed: an ACK of new data should be predicted");
+
+            test_2.execute(Write{"world"});
+            test_2.execute(ExpectOneSegment{}.with_seqno(tx_isn + 6).with_data("world"));
+            test_2.send_ack(rx_isn + 1, tx_isn + 6);
+            test_2.send_ack(rx_isn + 1, tx_isn + 6, 1000);
+            test_2.execute(ExpectBytesInFlight{5});
+            test_2.execute(ExpectPredictedSegments{1}, "test 2 failed: ACKs of nothing new should not be predicted");
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 11, 2000);
+            test_2.execute(ExpectBytesInFlight{0});
+            test_2.execute(ExpectPredictedSegments{2}, "test 2 failed: an ACK of new data should be predicted");
+
+            test_2.send_byte(rx_isn + 1, tx_isn + 11, 'x');
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_2.execute(ExpectData{}.with_data("x"));
+            test_2.execute(ExpectPredictedSegments{2}, "test 2 failed: data moving the window should not be predicted");
+        }
+
+        // test #3 and #4: segments that can change the state take the general path
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_3.send_fin(rx_isn + 1, tx_isn + 1);
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_3.execute(ExpectState{State::CLOSE_WAIT});
+            test_3.execute(ExpectPredictedSegments{0});
+        }
+
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_4.execute(Close{});
+            test_4.execute(ExpectOneSegment{}.with_fin(true).with_seqno(tx_isn + 1));
+            test_4.send_ack(rx_isn + 1, tx_isn + 2);
+            test_4.execute(ExpectState{State::FIN_WAIT_2});
+            test_4.execute(ExpectPredictedSegments{0}, "test 4 failed: the ACK of our FIN should not be predicted");
+
+            // 单向传输：我们结束之后，对方的数据仍然可以预测
+            test_4.send_byte(rx_isn + 1, tx_isn + 2, 'a');
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_4.execute(ExpectData{}.with_data("a"));
+            test_4.execute(ExpectState{State::FIN_WAIT_2});
+            test_4.execute(ExpectPredictedSegments{1}, "test 4 failed: data after our FIN should be predicted");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test #1: passive open, the peer's smaller MSS limits our segments
+        {
+            TCPConfig cfg{};
+            TCPTestHarness test_1(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(5000).with_mss(536));
+            TCPSegment seg =
+                test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_mss(cfg.mss),
+                                  "test 1 failed: SYN/ACK should carry our MSS");
+            const WrappingInt32 base = seg.header().seqno + 1;
+
+            test_1.send_ack(isn + 1, base, 5000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(Write{string(2000, 'x')}.with_bytes_written(2000));
+            test_1.execute(ExpectSegment{}.with_payload_size(536).with_seqno(base).with_mss(nullopt));
+            test_1.execute(ExpectSegment{}.with_payload_size(536).with_seqno(base + 536));
+            test_1.execute(ExpectSegment{}.with_payload_size(536).with_seqno(base + 1072));
+            test_1.execute(ExpectOneSegment{}.with_payload_size(392).with_seqno(base + 1608));
+        }
+
+        // test #2: active open with a small configured MSS, peer sends no MSS option
+        {
+            TCPConfig cfg{};
+            cfg.mss = 500;
+            TCPTestHarness test_2(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_2.execute(Connect{});
+            TCPSegment seg = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_mss(500),
+                                               "test 2 failed: SYN should carry the configured MSS");
+            const WrappingInt32 base = seg.header().seqno + 1;
+
+            test_2.execute(SendSegment{}.with_syn(true).with_ack(true).with_seqno(isn).with_ackno(base).with_win(5000));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1).with_syn(false));
+            test_2.execute(ExpectState{State::ESTABLISHED});
+
+            test_2.execute(Write{string(800, 'x')}.with_bytes_written(800));
+            test_2.execute(ExpectSegment{}.with_payload_size(500).with_seqno(base));
+            test_2.execute(ExpectOneSegment{}.with_payload_size(300).with_seqno(base + 500));
+        }
+
+        // test #3: active open, the peer's larger MSS does not raise ours
+        {
+            TCPConfig cfg{};
+            TCPTestHarness test_3(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_3.execute(Connect{});
+            TCPSegment seg = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_mss(cfg.mss));
+            const WrappingInt32 base = seg.header().seqno + 1;
+
+            test_3.execute(SendSegment{}.with_syn(true).with_ack(true).with_seqno(isn).with_ackno(base).with_win(5000).with_mss(
+                1460));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1));
+
+            test_3.execute(Write{string(1500, 'x')}.with_bytes_written(1500));
+            test_3.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base));
+            test_3.execute(ExpectOneSegment{}.with_payload_size(500).with_seqno(base + 1000));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
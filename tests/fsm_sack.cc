@@ -0,0 +1,141 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test #1: passive open with SACK, for both reassembler engines
+        for (const auto engine : {StreamReassembler::Engine::SortedMap, StreamReassembler::Engine::Bitmap}) {
+            TCPConfig cfg{};
+            cfg.sack = true;
+            cfg.reassembler_engine = engine;
+            TCPTestHarness test_1(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(5000).with_sack_permitted(true));
+            TCPSegment seg =
+                test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_sack_permitted(true),
+                                  "test 1 failed: SYN/ACK should accept SACK");
+            const WrappingInt32 base = seg.header().seqno + 1;
+            test_1.send_ack(isn + 1, base, 5000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            const auto send_data = [&](const uint32_t offset) {
+                test_1.execute(
+                    SendSegment{}.with_ack(true).with_ackno(base).with_win(5000).with_seqno(isn + 1 + offset).with_data(
+                        string(1000, 'x')));
+            };
+
+            send_data(1000);
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 1).with_sack({{isn + 1001, isn + 2001}}),
+                           "test 1 failed: out-of-order data should be SACKed");
+
+            // 最近收到的 block 排在最前面
+            send_data(3000);
+            test_1.execute(
+                ExpectOneSegment{}.with_ackno(isn + 1).with_sack({{isn + 3001, isn + 4001}, {isn + 1001, isn + 2001}}));
+
+            send_data(2000);
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 1).with_sack({{isn + 1001, isn + 4001}}),
+                           "test 1 failed: adjacent blocks should be merged");
+
+            send_data(0);
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 4001).with_sack({}),
+                           "test 1 failed: no SACK blocks once everything is assembled");
+        }
+
+        // test #2: more holes than blocks; later ACKs repeat the blocks reported most recently (RFC 2018 section 4)
+        for (const auto engine : {StreamReassembler::Engine::SortedMap, StreamReassembler::Engine::Bitmap}) {
+            TCPConfig cfg{};
+            cfg.sack = true;
+            cfg.reassembler_engine = engine;
+            TCPTestHarness test_2(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(5000).with_sack_permitted(true));
+            TCPSegment seg = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true));
+            const WrappingInt32 base = seg.header().seqno + 1;
+            test_2.send_ack(isn + 1, base, 5000);
+
+            const auto send_data = [&](const uint32_t offset) {
+                test_2.execute(
+                    SendSegment{}.with_ack(true).with_ackno(base).with_win(5000).with_seqno(isn + 1 + offset).with_data(
+                        string(1000, 'x')));
+            };
+            const auto block = [&](const uint32_t offset) {
+                return TCPHeader::SackBlock{isn + 1 + offset, isn + 1 + offset + 1000};
+            };
+
+            for (const uint32_t offset : {1000, 3000, 5000, 7000}) {
+                send_data(offset);
+                test_2.execute(ExpectOneSegment{}.with_ackno(isn + 1));
+            }
+            send_data(9000);
+            test_2.execute(
+                ExpectOneSegment{}.with_ackno(isn + 1).with_sack({block(9000), block(7000), block(5000), block(3000)}),
+                "test 2 failed: the oldest block should be dropped first");
+
+            send_data(1000);
+            test_2.execute(
+                ExpectOneSegment{}.with_ackno(isn + 1).with_sack({block(1000), block(9000), block(7000), block(5000)}),
+                "test 2 failed: the blocks reported last should be repeated");
+        }
+
+        // test #3: passive open, peer does not offer SACK
+        {
+            TCPConfig cfg{};
+            cfg.sack = true;
+            TCPTestHarness test_3(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(5000));
+            TCPSegment seg =
+                test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_sack_permitted(false),
+                                  "test 3 failed: SYN/ACK should not offer SACK to a peer that did not");
+            const WrappingInt32 base = seg.header().seqno + 1;
+            test_3.send_ack(isn + 1, base, 5000);
+
+            test_3.execute(
+                SendSegment{}.with_ack(true).with_ackno(base).with_win(5000).with_seqno(isn + 1001).with_data(
+                    string(1000, 'x')));
+            test_3.execute(ExpectOneSegment{}.with_ackno(isn + 1).with_sack({}),
+                           "test 3 failed: SACK blocks sent without negotiation");
+        }
+
+        // test #4 and #5: active open offers SACK only if enabled
+        {
+            TCPConfig cfg{};
+            cfg.sack = true;
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Connect{});
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_sack_permitted(true));
+
+            TCPTestHarness test_5(TCPConfig{});
+            test_5.execute(Connect{});
+            test_5.execute(ExpectOneSegment{}.with_syn(true).with_sack_permitted(false));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr auto BITMAP = StreamReassembler::Engine::Bitmap;
+
+int main() {
+    try {
+        {
+            ReassemblerTestHarness test{2, BITMAP};
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAvailable("ab"));
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(BytesAvailable("cd"));
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(BytesAssembled(6));
+            test.execute(BytesAvailable("ef"));
+        }
+
+        {
+            ReassemblerTestHarness test{2, BITMAP};
+
+            test.execute(SubmitSegment{"bX", 1});
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(1));
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAssembled(2));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("ab"));
+        }
+
+        {
+            ReassemblerTestHarness test{65000, BITMAP};
+
+            test.execute(SubmitSegment{"b", 1});
+            test.execute(SubmitSegment{"d", 3});
+            test.execute(UnassembledBytes(2));
+            test.execute(SubmitSegment{"abc", 0});
+            test.execute(BytesAssembled(4));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcd"));
+            test.execute(NotAtEof{});
+        }
+
+        {
+            ReassemblerTestHarness test{65000, BITMAP};
+
+            test.execute(SubmitSegment{"bcd", 1}.with_eof(true));
+            test.execute(SubmitSegment{"bc", 1});
+            test.execute(UnassembledBytes(3));
+            test.execute(NotAtEof{});
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAvailable("abcd"));
+            test.execute(AtEof{});
+        }
+
+        {
+            // a run of present bytes that wraps around the end of the ring
+            ReassemblerTestHarness test{8, BITMAP};
+
+            test.execute(SubmitSegment{"abcdef", 0});
+            test.execute(BytesAvailable("abcdef"));
+            test.execute(SubmitSegment{"hijk", 7});
+            test.execute(UnassembledBytes(4));
+            test.execute(SubmitSegment{"g", 6});
+            test.execute(BytesAssembled(11));
+            test.execute(BytesAvailable("ghijk"));
+        }
+
+        // the two engines agree on random overlapping substrings pushed in random order
+        auto rd = get_random_generator();
+        for (unsigned rep_no = 0; rep_no < 64; ++rep_no) {
+            const size_t capacity = 1 + rd() % 3000;
+            const size_t len = 1 + rd() % 20000;
+            string d(len, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            StreamReassembler sorted{capacity};
+            StreamReassembler bitmap{capacity, ByteStream::Backend::BufferList, BITMAP};
+            string sorted_out, bitmap_out;
+
+            while (not bitmap.stream_out().eof()) {
+                const size_t index = rd() % len;
+                const size_t size = min(len - index, size_t(1 + rd() % 300));
+                const bool eof = index + size == len;
+                sorted.push_substring(d.substr(index, size), index, eof);
+                bitmap.push_substring(d.substr(index, size), index, eof);
+
+                if (sorted.unassembled_bytes() != bitmap.unassembled_bytes()) {
+                    throw runtime_error("unassembled_bytes() differs between the engines");
+                }
+                if (sorted.stream_out().bytes_written() != bitmap.stream_out().bytes_written()) {
+                    throw runtime_error("bytes assembled differs between the engines");
+                }
+
+                const size_t to_read = rd() % (capacity + 1);
+                sorted_out += sorted.stream_out().read(to_read);
+                bitmap_out += bitmap.stream_out().read(to_read);
+            }
+
+            if (not sorted.stream_out().eof()) {
+                throw runtime_error("the sorted-map engine did not reach EOF");
+            }
+            if (sorted_out != d or bitmap_out != d) {
+                throw runtime_error("reassembled bytes are incorrect");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
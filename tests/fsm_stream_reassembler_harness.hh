@@ -164,8 +164,11 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
-        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
+    ReassemblerTestHarness(const size_t capacity,
+                           const StreamReassembler::Engine engine = StreamReassembler::Engine::SortedMap)
+        : reassembler(capacity, ByteStream::Backend::BufferList, engine), steps_executed() {
+        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ", engine = " +
+                                    (engine == StreamReassembler::Engine::Bitmap ? "bitmap" : "sorted map") + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
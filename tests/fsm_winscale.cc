@@ -0,0 +1,103 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.recv_capacity = 1 << 20;  // needs a shift of 5 to fit in 16 bits
+        cfg.window_scaling = true;
+
+        // test #1: passive open, both sides offer window scaling
+        {
+            TCPTestHarness test_1(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(1000).with_wscale(3));
+            TCPSegment seg = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(isn + 1).with_wscale(5).with_win(65535),
+                "test 1 failed: SYN/ACK should echo the window scale option with an unscaled window");
+
+            test_1.send_ack(isn + 1, seg.header().seqno + 1, 100);  // 100 << 3 = 800 bytes
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            test_1.execute(Write{string(2000, 'x')}.with_bytes_written(2000));
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_payload_size(800).with_win((1 << 20) >> 5),
+                           "test 1 failed: peer's window should be scaled, and ours advertised scaled");
+        }
+
+        // test #2: passive open, peer does not offer window scaling
+        {
+            TCPTestHarness test_2(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_2.execute(Listen{});
+            test_2.send_syn(isn);
+            TCPSegment seg = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_wscale(nullopt).with_win(65535),
+                "test 2 failed: SYN/ACK should not offer window scaling to a peer that did not");
+
+            test_2.send_ack(isn + 1, seg.header().seqno + 1, 100);
+            test_2.execute(Write{string(2000, 'x')}.with_bytes_written(2000));
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_payload_size(100).with_win(65535),
+                           "test 2 failed: windows should not be scaled");
+        }
+
+        // test #3: active open, both sides offer window scaling
+        {
+            TCPTestHarness test_3(cfg);
+            const WrappingInt32 isn(rd());
+
+            test_3.execute(Connect{});
+            TCPSegment seg = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false).with_wscale(5),
+                                               "test 3 failed: SYN should offer window scaling");
+            const WrappingInt32 base = seg.header().seqno + 1;
+
+            // the window in the SYN/ACK itself is never scaled
+            test_3.execute(
+                SendSegment{}.with_syn(true).with_ack(true).with_seqno(isn).with_ackno(base).with_win(1000).with_wscale(2));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1).with_win((1 << 20) >> 5));
+            test_3.execute(ExpectState{State::ESTABLISHED});
+
+            test_3.execute(Write{string(3000, 'x')}.with_bytes_written(3000));
+            test_3.execute(ExpectOneSegment{}.with_payload_size(1000).with_seqno(base));
+
+            test_3.send_ack(isn + 1, base + 1000, 500);  // 500 << 2 = 2000 bytes
+            test_3.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base + 1000));
+            test_3.execute(ExpectOneSegment{}.with_payload_size(1000).with_seqno(base + 2000));
+        }
+
+        // test #4: window scaling disabled
+        {
+            TCPConfig no_scaling = cfg;
+            no_scaling.window_scaling = false;
+            TCPTestHarness test_4(no_scaling);
+
+            test_4.execute(Connect{});
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_wscale(nullopt),
+                           "test 4 failed: SYN should not offer window scaling");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
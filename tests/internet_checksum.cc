@@ -0,0 +1,79 @@
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//! \returns the checksum of `data` after `initial_sum`, computed one byte at a time
+uint16_t reference_checksum(const string_view data, const uint32_t initial_sum) {
+    uint64_t sum = initial_sum;
+    for (size_t i = 0; i < data.size(); i++) {
+        sum += i % 2 ? uint8_t(data[i]) : uint8_t(data[i]) << 8;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+int main() {
+    try {
+        // RFC 1071 第 3 节的例子
+        {
+            const string data{"\x00\x01\xf2\x03\xf4\xf5\xf6\xf7", 8};
+            InternetChecksum check;
+            check.add(data);
+            test_should_be(check.value(), uint16_t(~0xddf2));
+
+            // 奇数长度：最后一个字节补零
+            InternetChecksum odd;
+            odd.add(data.substr(0, 7));
+            test_should_be(odd.value(), uint16_t(~(0xddf2 - 0xf7)));
+        }
+
+        // 任意长度、任意起始地址，分成任意多段，结果都与逐字节计算相同
+        {
+            auto rd = get_random_generator();
+            const string buffer = [&] {
+                string ret(70000, 0);
+                for (auto &ch : ret) {
+                    ch = rd();
+                }
+                return ret;
+            }();
+
+            for (size_t round = 0; round < 2000; round++) {
+                const size_t offset = uniform_int_distribution<size_t>{0, 7}(rd);
+                const size_t max_len = round % 10 ? 200 : buffer.size() - offset;
+                const size_t len = uniform_int_distribution<size_t>{0, max_len}(rd);
+                const string_view data = string_view{buffer}.substr(offset, len);
+                const uint32_t initial_sum = uniform_int_distribution<uint32_t>{0, 0x3ffff}(rd);
+
+                InternetChecksum check{initial_sum};
+                string_view rest = data;
+                while (not rest.empty()) {
+                    const size_t piece = uniform_int_distribution<size_t>{0, min<size_t>(rest.size(), 37)}(rd);
+                    check.add(rest.substr(0, piece));
+                    rest.remove_prefix(piece);
+                }
+                test_should_be(check.value(), reference_checksum(data, initial_sum));
+
+                InternetChecksum whole{initial_sum};
+                whole.add(data);
+                test_should_be(whole.value(), reference_checksum(data, initial_sum));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
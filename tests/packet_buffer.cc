@@ -0,0 +1,111 @@
+#include "buffer.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! \returns a segment with random fields, options and payload
+TCPSegment random_segment(mt19937 &rd) {
+    TCPSegment seg;
+    TCPHeader &header = seg.header();
+    header.seqno = WrappingInt32(rd());
+    header.ackno = WrappingInt32(rd());
+    header.ack = rd() % 2;
+    header.syn = rd() % 2;
+    header.fin = rd() % 2;
+    header.win = rd();
+    if (header.syn) {
+        if (rd() % 2) {
+            header.mss = uint16_t(rd());
+        }
+        if (rd() % 2) {
+            header.wscale = uint8_t(rd() % 15);
+        }
+        header.sack_permitted = rd() % 2;
+    } else {
+        const size_t blocks = rd() % (TCPHeader::MAX_SACK_BLOCKS + 1);
+        for (size_t i = 0; i < blocks; i++) {
+            header.sack.push_back({WrappingInt32(rd()), WrappingInt32(rd())});
+        }
+    }
+
+    string payload(uniform_int_distribution<size_t>{0, 1500}(rd), 0);
+    for (auto &ch : payload) {
+        ch = rd();
+    }
+    seg.payload() = Buffer(move(payload));
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // 头部空间用完时 prepend 抛出异常，已写入的首部不受影响
+        {
+            PacketBuffer packet{Buffer(string("payload"))};
+            char *const header = packet.prepend(PacketBuffer::HEADROOM);
+            header[0] = 'h';
+            bool threw = false;
+            try {
+                packet.prepend(1);
+            } catch (const out_of_range &) {
+                threw = true;
+            }
+            test_should_be(threw, true);
+            test_should_be(packet.size(), PacketBuffer::HEADROOM + 7);
+            test_should_be(packet.concatenate().front(), 'h');
+            test_should_be(BufferViewList(packet).as_iovecs().size(), size_t(2));
+        }
+
+        for (size_t round = 0; round < 1000; round++) {
+            TCPSegment seg = random_segment(rd);
+            const uint32_t pseudo_sum = rd() % 0x40000;
+
+            // 原地序列化的结果与 BufferList 版本逐字节相同，并且可以解析回原来的 segment
+            const PacketBuffer packet = seg.serialize_packet(pseudo_sum);
+            test_should_be(packet.concatenate() == seg.serialize(pseudo_sum).concatenate(), true);
+            test_should_be(packet.headers().size(), seg.header().length());
+
+            TCPSegment parsed;
+            test_should_be(parsed.parse(packet.concatenate(), pseudo_sum) == ParseResult::NoError, true);
+            TCPHeader expected = seg.header();
+            expected.doff = seg.header().length() / 4;
+            test_should_be(parsed.header() == expected, true);
+            test_should_be(parsed.payload().str() == seg.payload().str(), true);
+
+            // IPv4 首部也写在同一块头部空间里，结果与 InternetDatagram 的序列化相同
+            TCPOverIPv4Adapter adapter;
+            const FlowKey flow{uint32_t(rd()), uint32_t(rd()), uint16_t(rd()), uint16_t(rd())};
+            const string datagram = adapter.wrap_tcp_in_packet(seg, flow).concatenate();
+            test_should_be(datagram == adapter.wrap_tcp_in_ip(seg, flow).serialize().concatenate(), true);
+
+            InternetDatagram ip_dgram;
+            test_should_be(ip_dgram.parse(string(datagram)) == ParseResult::NoError, true);
+            test_should_be(ip_dgram.header().src, flow.local_address);
+            test_should_be(ip_dgram.header().dst, flow.remote_address);
+            TCPSegment unwrapped;
+            const ParseResult result = unwrapped.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum());
+            test_should_be(result == ParseResult::NoError, true);
+            test_should_be(unwrapped.header().sport, flow.local_port);
+            test_should_be(unwrapped.header().dport, flow.remote_port);
+            test_should_be(unwrapped.payload().str() == seg.payload().str(), true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno: initial window limits the first flight, slow start grows it", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{10000});
+            test.execute(WriteBytes(string(20000, 'x')));
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{10000});
+
+            // 每个 ack 的 segment 让窗口增加一个 MSS，因此可以再发送两个 segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 1000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{11000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 11000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno: timeout collapses the window to one segment", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(20000, 'x')));
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{1000});
+
+            // 全部确认后 slow start 只增加一个 MSS，阈值为丢包时 bytes in flight 的一半
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 11000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"Receiver window still applies under a larger congestion window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(2500));
+            test.execute(WriteBytes(string(20000, 'x')));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(500));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC: timeout sets the threshold to 70% of the window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(20000, 'x')));
+            for (unsigned int i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{1000});
+
+            // slow start 回到 7000 字节后停止
+            for (unsigned int i = 1; i <= 6; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 1000 * i}}.with_win(60000));
+            }
+            test.execute(ExpectCongestionWindow{7000});
+        }
+
+        {
+            // CUBIC 在 congestion avoidance 中先快速回到丢包前的窗口，在其附近放缓，之后再加速增长
+            CongestionControl cubic{CongestionControl::Algorithm::Cubic, 1000};
+            uint64_t now = 0;
+            auto ack_window = [&] {
+                const uint64_t cwnd = cubic.window();
+                for (uint64_t acked = 0; acked < cwnd; acked += 1000) {
+                    cubic.on_ack(1000, now);
+                }
+            };
+            for (unsigned int i = 0; i < 4; i++) {
+                ack_window();  // slow start: 10 -> 160 segments
+            }
+            const uint64_t w_max = cubic.window();
+            cubic.on_loss(w_max, now);
+            if (cubic.window() != w_max * 7 / 10 or cubic.in_slow_start()) {
+                throw runtime_error("CUBIC should reduce the window to 70% on loss");
+            }
+
+            // K = cbrt(160 * 0.3 / 0.4) ≈ 4.9 秒
+            for (now = 100; now <= 4000; now += 100) {
+                ack_window();
+            }
+            if (cubic.window() <= w_max * 9 / 10 or cubic.window() > w_max) {
+                throw runtime_error("CUBIC should approach the window before the loss, but not pass it, within K");
+            }
+            for (; now <= 10000; now += 100) {
+                ack_window();
+            }
+            if (cubic.window() <= w_max * 11 / 10) {
+                throw runtime_error("CUBIC should grow past the window before the loss after K");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without congestion control, the receiver's window is the only limit", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(20000, 'x')));
+            for (unsigned int i = 0; i < 20; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -435,6 +435,31 @@ int main() {
             test.execute(ExpectNoSegment{});
             test.execute(ExpectState{TCPSenderStateSummary::FIN_ACKED});
         }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(UINT32_MAX - 15);
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"ACK of a segment that wraps around the sequence space releases it", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes(string(32, 'x')));
+            test.execute(ExpectSegment{}.with_payload_size(32).with_seqno(isn + 1));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 33));
+            test.execute(AckReceived{WrappingInt32{isn + 33}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{3});
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 33));
+            test.execute(AckReceived{WrappingInt32{isn + 36}}.with_win(1000));
+            test.execute(Tick{4 * rto});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
@@ -0,0 +1,73 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle's algorithm holds small writes while data is unacknowledged", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes{"def"});
+            test.execute(WriteBytes{"ghi"});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_data("defghi").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+
+            // 凑满一个 MSS 的数据不受影响
+            test.execute(WriteBytes(string(2500, 'x')));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 10));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1010));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2010}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(500).with_seqno(isn + 2010));
+
+            // 流结束时不再等待
+            test.execute(WriteBytes{"end"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_data("end").with_fin(true).with_seqno(isn + 2510));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Cork holds short segments until uncork", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(Cork{});
+            test.execute(WriteBytes{"GET / HTTP/1.1\r\n"});
+            test.execute(WriteBytes{"Host: example.com\r\n"});
+            test.execute(ExpectNoSegment{});
+            test.execute(WriteBytes(string(1000, 'x')));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Uncork{});
+            test.execute(ExpectSegment{}.with_payload_size(35).with_seqno(isn + 1001));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc").with_seqno(isn + 1036));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
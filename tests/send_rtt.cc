@@ -0,0 +1,96 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"RTO follows the first RTT sample", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            // SRTT = 100, RTTVAR = 50，RTO = 100 + 4 * 50 = 300
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+
+            // Karn 算法：重传过的 segment 不产生样本，退避后的 RTO (600) 保持不变
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(WriteBytes("def"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+            test.execute(Tick{599});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.min_rto = 50;
+            cfg.max_rto = 400;
+
+            TCPSenderTestHarness test{"Adaptive RTO stays within its bounds", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            // SRTT = 1, RTTVAR = 0.5，RTO = 3，低于下限 50
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{49});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+
+            // 退避：100, 200, 400, 然后一直是上限 400
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{200});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{400});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{399});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+        }
+
+        {
+            // 多个样本按 RFC 6298 平滑
+            RTTEstimator rtt;
+            rtt.add_sample(100);
+            rtt.add_sample(200);
+            // RTTVAR = 3/4 * 50 + 1/4 * 100 = 62.5，SRTT = 7/8 * 100 + 1/8 * 200 = 112.5
+            if (rtt.samples() != 2 or rtt.srtt() != 112.5 or rtt.rttvar() != 62.5 or rtt.min_rtt() != 100 or
+                rtt.latest_rtt() != 200 or rtt.rto(200, 60000) != 362) {
+                throw runtime_error("RTTEstimator did not follow RFC 6298");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
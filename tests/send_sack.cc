@@ -0,0 +1,127 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK blocks let fast recovery retransmit every hole, and only the holes", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes(string(8000, 'x')));
+            for (unsigned int i = 0; i < 8; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+
+            // segment 0、2、5 丢失
+            const WrappingInt32 base = isn + 1;
+            const auto ack = [&](const WrappingInt32 ackno, vector<TCPHeader::SackBlock> blocks) {
+                test.execute(AckReceived{ackno}.with_win(10000).with_sack(move(blocks)));
+            };
+            ack(base, {{base + 1000, base + 2000}});
+            ack(base, {{base + 3000, base + 4000}, {base + 1000, base + 2000}});
+            test.execute(ExpectNoSegment{});
+            ack(base, {{base + 3000, base + 5000}, {base + 1000, base + 2000}});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base));
+            test.execute(ExpectNoSegment{});
+
+            // 之后每个重复 ack 重传下一个空洞；segment 1、3、4 已经被 SACK，不会重传
+            ack(base, {{base + 6000, base + 7000}, {base + 3000, base + 5000}});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base + 2000));
+            test.execute(ExpectNoSegment{});
+            ack(base, {{base + 6000, base + 8000}, {base + 3000, base + 5000}});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base + 5000));
+            test.execute(ExpectNoSegment{});
+            ack(base, {{base + 6000, base + 8000}, {base + 3000, base + 5000}});
+            test.execute(ExpectNoSegment{});
+
+            // partial ack 之后没有新的空洞，不重传
+            ack(base + 2000, {{base + 3000, base + 5000}, {base + 6000, base + 8000}});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{base + 8000}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK blocks outside the outstanding data are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes(string(3000, 'x')));
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            const WrappingInt32 base = isn + 1;
+            const auto ack = [&](const WrappingInt32 ackno, vector<TCPHeader::SackBlock> blocks) {
+                test.execute(AckReceived{ackno}.with_win(10000).with_sack(move(blocks)));
+            };
+            for (unsigned int i = 0; i < 3; i++) {
+                ack(base, {{base + 2000, base + 5000}, {base - 100, base}});
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base));
+            ack(base, {{base + 2000, base + 5000}});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"A timeout forgets the SACK scoreboard, since the receiver may renege", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes(string(6000, 'x')));
+            for (unsigned int i = 0; i < 6; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            const WrappingInt32 base = isn + 1;
+            const auto ack = [&](const WrappingInt32 ackno, vector<TCPHeader::SackBlock> blocks) {
+                test.execute(AckReceived{ackno}.with_win(10000).with_sack(move(blocks)));
+            };
+
+            // segment 4 被 SACK，之后超时
+            ack(base, {{base + 4000, base + 5000}});
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base));
+            ack(base + 1000, {});
+
+            // 接收方丢弃了 segment 4：之后的 SACK 只报告 segment 5，segment 4 也是需要重传的空洞
+            for (unsigned int i = 0; i < 3; i++) {
+                ack(base + 1000, {{base + 5000, base + 6000}});
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base + 1000));
+            for (unsigned int i = 2; i < 5; i++) {
+                ack(base + 1000, {{base + 5000, base + 6000}});
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(base + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,22 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    uint64_t _cwnd;
+
+    ExpectCongestionWindow(uint64_t cwnd) : _cwnd(cwnd) {}
+    std::string description() const { return "congestion window " + std::to_string(_cwnd); }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_control().window() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_control().window()
+               << " bytes, but it was expected to be " << _cwnd << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +208,15 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<TCPHeader::SackBlock> _sack{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack) {
+            ss << " sack " << block.left << "-" << block.right;
+        }
         return ss.str();
     }
 
@@ -204,7 +225,15 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(std::vector<TCPHeader::SackBlock> sack) {
+        _sack = std::move(sack);
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (not _sack.empty()) {
+            sender.sack_received(_sack);
+        }
         sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
         sender.fill_window();
     }
@@ -220,6 +249,20 @@ struct Close : public SenderAction {
     }
 };
 
+struct Cork : public SenderAction {
+    Cork() {}
+    std::string description() const { return "cork"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.cork(); }
+};
+
+struct Uncork : public SenderAction {
+    Uncork() {}
+    std::string description() const { return "uncork"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.uncork(); }
+};
+
 struct ExpectSegment : public SenderExpectation {
     std::optional<bool> ack{};
     std::optional<bool> rst{};
@@ -394,7 +437,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -0,0 +1,169 @@
+#include "tcp_endpoint.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+void check(const bool condition, const string &expected, const int lineno) {
+    if (not condition) {
+        throw runtime_error("expected " + expected + " (at line " + to_string(lineno) + ")");
+    }
+}
+
+//! An endpoint on its own UDP socket on the loopback interface, and the socket's address
+pair<unique_ptr<TCPOverUDPEndpoint>, Address> make_endpoint(const TCPConfig &config) {
+    UDPSocket sock;
+    sock.bind({"127.0.0.1", 0});
+    FdAdapterConfig c_ad{};
+    c_ad.source = sock.local_address();
+    return {make_unique<TCPOverUDPEndpoint>(TCPOverUDPSocketAdapter{move(sock)}, config, c_ad), c_ad.source};
+}
+
+//! Let every endpoint handle what is due until `done` (or give up after a few seconds)
+void pump_until(const vector<TCPOverUDPEndpoint *> &endpoints, const function<bool()> &done, const int lineno) {
+    for (size_t round = 0; round < 5000; round++) {
+        if (done()) {
+            return;
+        }
+        for (auto *endpoint : endpoints) {
+            endpoint->wait_next_event(1);
+        }
+    }
+    check(done(), "condition to become true", lineno);
+}
+
+int main() {
+    try {
+        TCPConfig config;
+        config.rt_timeout = 10;
+
+        // 一个 endpoint 服务多个连接：按 flow 分发，各自回显
+        {
+            constexpr size_t num_clients = 8;
+            auto [server, server_address] = make_endpoint(config);
+            vector<FlowKey> accepted;
+            vector<FlowKey> ended;
+            TCPOverUDPEndpoint &srv = *server;
+            srv.set_handler([&](const FlowKey &flow) {
+                const ByteStream &inbound = srv.connection(flow).inbound_stream();
+                if (inbound.buffer_size() > 0) {
+                    srv.write(flow, srv.read(flow, 65536));
+                }
+                if (inbound.eof() and find(ended.begin(), ended.end(), flow) == ended.end()) {
+                    srv.end_input_stream(flow);
+                    ended.push_back(flow);
+                }
+            });
+            srv.listen(num_clients);
+
+            vector<unique_ptr<TCPOverUDPEndpoint>> clients;
+            vector<FlowKey> client_flows;
+            vector<string> echoed(num_clients);
+            vector<TCPOverUDPEndpoint *> endpoints{server.get()};
+            for (size_t i = 0; i < num_clients; i++) {
+                clients.push_back(make_endpoint(config).first);
+                TCPOverUDPEndpoint *const client = clients.back().get();
+                client->set_handler(
+                    [&echoed, client, i](const FlowKey &flow) { echoed[i] += client->read(flow, 65536); });
+                client_flows.push_back(client->connect(server_address));
+                endpoints.push_back(client);
+            }
+
+            pump_until(
+                endpoints,
+                [&] {
+                    while (const auto flow = srv.accept()) {
+                        accepted.push_back(flow.value());
+                    }
+                    return accepted.size() == num_clients;
+                },
+                __LINE__);
+            check(srv.size() == num_clients, "a connection per client", __LINE__);
+            set<uint16_t> ports;
+            for (const auto &flow : accepted) {
+                ports.insert(flow.remote_port);
+                check(srv.connection(flow).fsm_state() == TCPState::State::ESTABLISHED, "ESTABLISHED", __LINE__);
+            }
+            check(ports.size() == num_clients, "a flow per client", __LINE__);
+
+            for (size_t i = 0; i < num_clients; i++) {
+                clients[i]->write(client_flows[i], "hello from client " + to_string(i));
+                clients[i]->end_input_stream(client_flows[i]);
+            }
+            pump_until(
+                endpoints,
+                [&] {
+                    for (size_t i = 0; i < num_clients; i++) {
+                        if (echoed[i] != "hello from client " + to_string(i)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                },
+                __LINE__);
+
+            // 两边都结束后连接被遗忘
+            pump_until(
+                endpoints,
+                [&] {
+                    size_t remaining = srv.size();
+                    for (const auto &client : clients) {
+                        remaining += client->size();
+                    }
+                    return remaining == 0;
+                },
+                __LINE__);
+        }
+
+        // backlog 满时新的 SYN 被丢弃；accept() 之后重传的 SYN 被接受
+        {
+            constexpr size_t num_clients = 4;
+            auto [server, server_address] = make_endpoint(config);
+            TCPOverUDPEndpoint &srv = *server;
+            srv.listen(2);
+
+            vector<unique_ptr<TCPOverUDPEndpoint>> clients;
+            vector<TCPOverUDPEndpoint *> endpoints{server.get()};
+            for (size_t i = 0; i < num_clients; i++) {
+                clients.push_back(make_endpoint(config).first);
+                clients.back()->connect(server_address);
+                endpoints.push_back(clients.back().get());
+            }
+
+            for (size_t round = 0; round < 100; round++) {
+                for (auto *endpoint : endpoints) {
+                    endpoint->wait_next_event(1);
+                }
+            }
+            check(srv.size() == 2, "only the backlog's worth of connections", __LINE__);
+
+            size_t accepted = 0;
+            pump_until(
+                endpoints,
+                [&] {
+                    while (srv.accept().has_value()) {
+                        accepted++;
+                    }
+                    return accepted == num_clients;
+                },
+                __LINE__);
+            check(srv.size() == num_clients, "every connection after accept()", __LINE__);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
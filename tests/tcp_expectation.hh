@@ -11,6 +11,7 @@
 #include <exception>
 #include <optional>
 #include <sstream>
+#include <vector>
 
 struct TCPExpectation : public TCPTestStep {
     virtual ~TCPExpectation() {}
@@ -121,6 +122,10 @@ struct ExpectSegment : public TCPExpectation {
     std::optional<WrappingInt32> seqno{};
     std::optional<WrappingInt32> ackno{};
     std::optional<uint16_t> win{};
+    std::optional<std::optional<uint16_t>> mss{};
+    std::optional<std::optional<uint8_t>> wscale{};
+    std::optional<bool> sack_permitted{};
+    std::optional<std::vector<TCPHeader::SackBlock>> sack{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
 
@@ -171,6 +176,29 @@ struct ExpectSegment : public TCPExpectation {
         return *this;
     }
 
+    //! \param[in] mss_ the expected maximum segment size option, or std::nullopt if the option must be absent
+    ExpectSegment &with_mss(std::optional<uint16_t> mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    //! \param[in] wscale_ the expected window scale option, or std::nullopt if the option must be absent
+    ExpectSegment &with_wscale(std::optional<uint8_t> wscale_) {
+        wscale = wscale_;
+        return *this;
+    }
+
+    ExpectSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    //! \param[in] sack_ the expected SACK blocks, in order (empty if the option must be absent)
+    ExpectSegment &with_sack(std::vector<TCPHeader::SackBlock> sack_) {
+        sack = std::move(sack_);
+        return *this;
+    }
+
     ExpectSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -202,6 +230,22 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value()) {
             o << "win=" << win.value() << ",";
         }
+        if (mss.has_value()) {
+            o << "mss=" << (mss.value().has_value() ? std::to_string(mss.value().value()) : "none") << ",";
+        }
+        if (sack_permitted.has_value()) {
+            o << "sackOK=" << sack_permitted.value() << ",";
+        }
+        if (sack.has_value()) {
+            o << "sack=[";
+            for (const auto &block : sack.value()) {
+                o << block.left << "-" << block.right << " ";
+            }
+            o << "],";
+        }
+        if (wscale.has_value()) {
+            o << "wscale=" << (wscale.value().has_value() ? std::to_string(wscale.value().value()) : "none") << ",";
+        }
         if (seqno.has_value()) {
             o << "seqno=" << seqno.value() << ",";
         }
@@ -248,6 +292,26 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value() and seg.header().win != win.value()) {
             throw SegmentExpectationViolation::violated_field("win", win.value(), seg.header().win);
         }
+        if (mss.has_value() and seg.header().mss != mss.value()) {
+            throw SegmentExpectationViolation("maximum segment size option differs (expected " +
+                                              (mss.value().has_value() ? std::to_string(*mss.value()) : "none") +
+                                              ", got " +
+                                              (seg.header().mss ? std::to_string(*seg.header().mss) : "none") + ")");
+        }
+        if (wscale.has_value() and seg.header().wscale != wscale.value()) {
+            throw SegmentExpectationViolation("window scale option differs (expected " +
+                                              (wscale.value().has_value() ? std::to_string(*wscale.value()) : "none") +
+                                              ", got " +
+                                              (seg.header().wscale ? std::to_string(*seg.header().wscale) : "none") +
+                                              ")");
+        }
+        if (sack_permitted.has_value() and seg.header().sack_permitted != sack_permitted.value()) {
+            throw SegmentExpectationViolation::violated_field(
+                "sack_permitted", sack_permitted.value(), seg.header().sack_permitted);
+        }
+        if (sack.has_value() and seg.header().sack != sack.value()) {
+            throw SegmentExpectationViolation("SACK blocks differ (got " + seg.header().summary() + ")");
+        }
         if (payload_size.has_value() and seg.payload().size() != payload_size.value()) {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
@@ -302,6 +366,11 @@ struct ExpectState : public TCPExpectation {
         if (actual_state != state) {
             throw StateExpectationViolation{state, actual_state};
         }
+        // the incrementally tracked state must agree with the one derived from the sender and receiver
+        const TCPState tracked_state = harness._fsm.fsm_state();
+        if (tracked_state != actual_state) {
+            throw StateExpectationViolation{actual_state, tracked_state};
+        }
     }
 };
 
@@ -363,6 +432,25 @@ struct ExpectUnassembledBytes : public TCPExpectation {
     }
 };
 
+struct ExpectPredictedSegments : public TCPExpectation {
+    size_t segments;
+
+    ExpectPredictedSegments(size_t segments_) : segments(segments_) {}
+
+    std::string description() const {
+        std::ostringstream o;
+        o << "TCP has handled " << segments << " segments by header prediction";
+        return o.str();
+    }
+
+    void execute(TCPTestHarness &harness) const {
+        size_t actual_segments = harness._fsm.predicted_segments();
+        if (actual_segments != segments) {
+            throw TCPPropertyViolation::make("predicted_segments", segments, actual_segments);
+        }
+    }
+};
+
 struct ExpectLingerTimer : public TCPExpectation {
     uint64_t ms;
 
@@ -390,6 +478,10 @@ struct SendSegment : public TCPAction {
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{0};
+    std::optional<uint16_t> mss{};
+    std::optional<uint8_t> wscale{};
+    bool sack_permitted{false};
+    std::vector<TCPHeader::SackBlock> sack{};
     size_t payload_size{0};
     std::string data{};
 
@@ -403,6 +495,10 @@ struct SendSegment : public TCPAction {
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
+        mss = seg.header().mss;
+        wscale = seg.header().wscale;
+        sack_permitted = seg.header().sack_permitted;
+        sack = seg.header().sack;
         data = seg.payload();
     }
 
@@ -445,6 +541,26 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_mss(uint16_t mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    SendSegment &with_wscale(uint8_t wscale_) {
+        wscale = wscale_;
+        return *this;
+    }
+
+    SendSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    SendSegment &with_sack(std::vector<TCPHeader::SackBlock> sack_) {
+        sack = std::move(sack_);
+        return *this;
+    }
+
     SendSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -466,6 +582,10 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.mss = mss;
+        data_hdr.wscale = wscale;
+        data_hdr.sack_permitted = sack_permitted;
+        data_hdr.sack = sack;
         return data_seg;
     }
 
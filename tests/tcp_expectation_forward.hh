@@ -30,6 +30,7 @@ struct ExpectNoData;
 struct ExpectSegmentAvailable;
 struct ExpectBytesInFlight;
 struct ExpectUnassembledBytes;
+struct ExpectPredictedSegments;
 struct ExpectWaitTimer;
 struct SendSegment;
 struct Write;
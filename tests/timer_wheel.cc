@@ -0,0 +1,125 @@
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // the basics
+        {
+            TimerWheel wheel{1000};
+            vector<int> fired;
+            wheel.add(1010, [&] { fired.push_back(10); });
+            wheel.add(1005, [&] { fired.push_back(5); });
+            const auto cancelled = wheel.add(1007, [&] { fired.push_back(7); });
+            test_should_be(wheel.size(), size_t(3));
+            test_should_be(wheel.next_expiry().value(), uint64_t(1005));
+
+            wheel.cancel(cancelled);
+            wheel.advance(1009);
+            test_should_be(fired.size(), size_t(1));
+            test_should_be(fired.at(0), 5);
+            wheel.advance(1010);
+            test_should_be(fired.size(), size_t(2));
+            test_should_be(fired.at(1), 10);
+            test_should_be(wheel.size(), size_t(0));
+            test_should_be(wheel.next_expiry().has_value(), false);
+
+            // 已经过去的 deadline 在下一毫秒过期
+            wheel.add(0, [&] { fired.push_back(0); });
+            wheel.advance(1010);
+            test_should_be(fired.size(), size_t(2));
+            wheel.advance(1011);
+            test_should_be(fired.size(), size_t(3));
+        }
+
+        // callbacks can add and cancel timers
+        {
+            TimerWheel wheel{};
+            size_t count = 0;
+            TimerWheel::TimerId victim = 0;
+            wheel.add(100, [&] {
+                count++;
+                wheel.cancel(victim);
+                wheel.add(wheel.now() + 50, [&] { count++; });
+            });
+            victim = wheel.add(100, [&] { count += 100; });
+            wheel.advance(149);
+            test_should_be(count, size_t(1));
+            wheel.advance(150);
+            test_should_be(count, size_t(2));
+        }
+
+        // compare with a sorted map, over every level and beyond the span of the wheel
+        auto rd = get_random_generator();
+        for (unsigned int rep = 0; rep < 20; rep++) {
+            const uint64_t start = rd() % 100000;
+            TimerWheel wheel{start};
+            multimap<uint64_t, TimerWheel::TimerId> expected;
+            map<TimerWheel::TimerId, uint64_t> deadlines;
+            vector<pair<uint64_t, uint64_t>> fired;  // (deadline, time of expiry)
+
+            const auto add = [&](const uint64_t deadline) {
+                const auto id = wheel.add(deadline, [&, deadline] { fired.emplace_back(deadline, wheel.now()); });
+                expected.emplace(deadline, id);
+                deadlines[id] = deadline;
+            };
+            for (unsigned int i = 0; i < 2000; i++) {
+                const unsigned int bits = 1 + rd() % 27;
+                add(start + 1 + (rd() & ((1U << bits) - 1)));
+            }
+            // 取消一部分
+            for (unsigned int i = 0; i < 300; i++) {
+                auto it = deadlines.begin();
+                advance(it, rd() % deadlines.size());
+                wheel.cancel(it->first);
+                for (auto e = expected.begin(); e != expected.end(); ++e) {
+                    if (e->second == it->first) {
+                        expected.erase(e);
+                        break;
+                    }
+                }
+                deadlines.erase(it);
+            }
+
+            uint64_t now = start;
+            while (!expected.empty()) {
+                const auto next = wheel.next_expiry();
+                if (!next.has_value() || next.value() > expected.begin()->first) {
+                    throw runtime_error("next_expiry() is later than the earliest deadline");
+                }
+                now += 1 + rd() % (rd() % 2 ? 100 : 1000000);
+                fired.clear();
+                wheel.advance(now);
+                size_t due = 0;
+                while (!expected.empty() && expected.begin()->first <= now) {
+                    expected.erase(expected.begin());
+                    due++;
+                }
+                test_should_be(fired.size(), due);
+                for (size_t i = 0; i < fired.size(); i++) {
+                    test_should_be(fired[i].second, fired[i].first);
+                    if (i > 0 && fired[i].second < fired[i - 1].second) {
+                        throw runtime_error("timers expired out of order");
+                    }
+                }
+                test_should_be(wheel.size(), expected.size());
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}